@@ -0,0 +1,915 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "fakekglobalacceld.h"
+
+#include "kglobalaccel.h"
+#include "kglobalshortcutinfo_p.h"
+
+#include <QCoreApplication>
+#include <QDBusConnectionInterface>
+#include <QDBusContext>
+#include <QDBusMessage>
+#include <QDBusMetaType>
+#include <QDBusObjectPath>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+#include <QThread>
+
+#include <algorithm>
+#include <memory>
+
+namespace
+{
+// Must match SetShortcutFlag in kglobalaccel_p.h
+enum SetShortcutFlag {
+    SetPresent = 2,
+    NoAutoloading = 4,
+    IsDefault = 8,
+};
+
+QString serviceName()
+{
+    return QStringLiteral("org.kde.kglobalaccel");
+}
+
+// Where the private bus listens if it is the session bus, see useAsSessionBus()
+QString &sessionBusSocket()
+{
+    static QString socket;
+    return socket;
+}
+}
+
+class FakeComponent;
+
+// Named like kglobalacceld's class so it may fill in KGlobalShortcutInfo
+class GlobalShortcut
+{
+public:
+    KGlobalShortcutInfo info(const FakeComponent *component) const;
+
+    QString uniqueName;
+    QString friendlyName;
+    QList<QKeySequence> keys;
+    QList<QKeySequence> defaultKeys;
+    bool isPresent = false;
+    //! Never got keys assigned, autoloading doesn't keep anything then
+    bool isFresh = true;
+};
+
+class FakeComponent : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kglobalaccel.Component")
+
+    Q_SCRIPTABLE Q_PROPERTY(QString friendlyName READ friendlyName)
+    Q_SCRIPTABLE Q_PROPERTY(QString uniqueName READ uniqueName)
+
+public:
+    FakeComponent(const QString &uniqueName, const QString &friendlyName, QObject *parent)
+        : QObject(parent)
+        , m_uniqueName(uniqueName)
+        , m_friendlyName(friendlyName)
+    {
+    }
+
+    QString friendlyName() const
+    {
+        return m_friendlyName.isEmpty() ? m_uniqueName : m_friendlyName;
+    }
+
+    QString uniqueName() const
+    {
+        return m_uniqueName;
+    }
+
+    void setFriendlyName(const QString &name)
+    {
+        m_friendlyName = name;
+    }
+
+    QDBusObjectPath dbusPath() const
+    {
+        // Same mangling as kglobalacceld
+        QString path = m_uniqueName;
+        path.replace(QRegularExpression(QStringLiteral("[^A-Za-z0-9_]")), QStringLiteral("_"));
+        if (!path.isEmpty() && path.at(0).isDigit()) {
+            path.prepend(QLatin1Char('_'));
+        }
+        return QDBusObjectPath(QLatin1String("/component/") + path);
+    }
+
+    QMap<QString, GlobalShortcut> shortcuts;
+
+public Q_SLOTS:
+    Q_SCRIPTABLE bool cleanUp()
+    {
+        bool changed = false;
+        for (auto it = shortcuts.begin(); it != shortcuts.end();) {
+            if (!it->isPresent) {
+                it = shortcuts.erase(it);
+                changed = true;
+            } else {
+                ++it;
+            }
+        }
+        return changed;
+    }
+
+    Q_SCRIPTABLE bool isActive() const
+    {
+        return std::any_of(shortcuts.cbegin(), shortcuts.cend(), [](const GlobalShortcut &shortcut) {
+            return shortcut.isPresent;
+        });
+    }
+
+    Q_SCRIPTABLE QStringList shortcutNames(const QString &context = QString()) const
+    {
+        Q_UNUSED(context)
+        return shortcuts.keys();
+    }
+
+    Q_SCRIPTABLE QList<KGlobalShortcutInfo> allShortcutInfos(const QString &context = QString()) const
+    {
+        Q_UNUSED(context)
+        QList<KGlobalShortcutInfo> infos;
+        infos.reserve(shortcuts.size());
+        for (const GlobalShortcut &shortcut : shortcuts) {
+            infos.append(shortcut.info(this));
+        }
+        return infos;
+    }
+
+    Q_SCRIPTABLE KGlobalShortcutInfoTable shortcutInfoTable(const QString &context) const
+    {
+        return KGlobalShortcutInfoTable(allShortcutInfos(context));
+    }
+
+    Q_SCRIPTABLE QStringList getShortcutContexts() const
+    {
+        return {QStringLiteral("default")};
+    }
+
+    Q_SCRIPTABLE void invokeShortcut(const QString &actionName)
+    {
+        Q_EMIT globalShortcutPressed(m_uniqueName, actionName, 0);
+        Q_EMIT globalShortcutReleased(m_uniqueName, actionName, 0);
+    }
+
+Q_SIGNALS:
+    Q_SCRIPTABLE void globalShortcutPressed(const QString &componentUnique, const QString &actionUnique, qlonglong timestamp);
+    Q_SCRIPTABLE void globalShortcutRepeated(const QString &componentUnique, const QString &actionUnique, qlonglong timestamp);
+    Q_SCRIPTABLE void globalShortcutReleased(const QString &componentUnique, const QString &actionUnique, qlonglong timestamp);
+
+private:
+    QString m_uniqueName;
+    QString m_friendlyName;
+};
+
+KGlobalShortcutInfo GlobalShortcut::info(const FakeComponent *component) const
+{
+    KGlobalShortcutInfo info;
+    info.d->uniqueName = uniqueName;
+    info.d->friendlyName = friendlyName;
+    info.d->componentUniqueName = component->uniqueName();
+    info.d->componentFriendlyName = component->friendlyName();
+    info.d->contextUniqueName = QStringLiteral("default");
+    info.d->keys = keys;
+    info.d->defaultKeys = defaultKeys;
+    return info;
+}
+
+class FakeKGlobalAccelService : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.KGlobalAccel")
+
+public:
+    explicit FakeKGlobalAccelService(const QString &address)
+        : m_address(address)
+    {
+    }
+
+    // Everything below is called in the daemon thread
+
+    bool connectToBus()
+    {
+        const QString connectionName = QStringLiteral("fakekglobalacceld-%1").arg(++m_generation);
+        m_connection = std::make_unique<QDBusConnection>(QDBusConnection::connectToBus(m_address, connectionName));
+        if (!m_connection->isConnected()) {
+            qWarning() << "Fake kglobalacceld failed to connect to" << m_address << m_connection->lastError();
+            return false;
+        }
+
+        m_connection->registerObject(QStringLiteral("/kglobalaccel"), this, QDBusConnection::ExportScriptableContents);
+        for (FakeComponent *component : std::as_const(m_components)) {
+            m_connection->registerObject(component->dbusPath().path(), component, QDBusConnection::ExportScriptableContents);
+        }
+        return m_connection->registerService(serviceName());
+    }
+
+    void disconnectFromBus()
+    {
+        if (!m_connection) {
+            return;
+        }
+        const QString name = m_connection->name();
+        m_connection.reset();
+        QDBusConnection::disconnectFromBus(name);
+    }
+
+    void forgetPresence()
+    {
+        for (FakeComponent *component : std::as_const(m_components)) {
+            for (GlobalShortcut &shortcut : component->shortcuts) {
+                shortcut.isPresent = false;
+            }
+        }
+    }
+
+    FakeComponent *component(const QString &componentUnique) const
+    {
+        return m_components.value(componentUnique);
+    }
+
+    GlobalShortcut *shortcut(const QString &componentUnique, const QString &actionUnique) const
+    {
+        FakeComponent *c = component(componentUnique);
+        if (!c) {
+            return nullptr;
+        }
+        auto it = c->shortcuts.find(actionUnique);
+        return it != c->shortcuts.end() ? &*it : nullptr;
+    }
+
+    GlobalShortcut *shortcut(const QStringList &actionId) const
+    {
+        if (actionId.size() < 2) {
+            return nullptr;
+        }
+        return shortcut(actionId.at(KGlobalAccel::ComponentUnique), actionId.at(KGlobalAccel::ActionUnique));
+    }
+
+    void changeKeys(const QString &componentUnique, const QString &actionUnique, const QList<QKeySequence> &keys)
+    {
+        GlobalShortcut *sc = shortcut(componentUnique, actionUnique);
+        if (!sc) {
+            return;
+        }
+        sc->keys = keys;
+        sc->isFresh = false;
+        Q_EMIT yourShortcutsChanged({componentUnique, actionUnique, component(componentUnique)->friendlyName(), sc->friendlyName}, keys);
+    }
+
+    void delayReply()
+    {
+        if (replyDelay.count() > 0) {
+            QThread::sleep(replyDelay);
+        }
+    }
+
+    void countCall()
+    {
+        if (calledFromDBus()) {
+            QMutexLocker locker(&callCountsMutex);
+            ++callCounts[message().member()];
+        }
+        delayReply();
+    }
+
+    std::chrono::milliseconds replyDelay{0};
+    //! Whether the methods returning KGlobalShortcutInfoTable exist, as in older kglobalacceld they don't
+    bool infoTablesSupported = true;
+    QHash<QString, int> callCounts;
+    mutable QMutex callCountsMutex;
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QList<QDBusObjectPath> allComponents() const
+    {
+        QList<QDBusObjectPath> paths;
+        for (FakeComponent *component : std::as_const(m_components)) {
+            paths.append(component->dbusPath());
+        }
+        return paths;
+    }
+
+    Q_SCRIPTABLE QDBusObjectPath getComponent(const QString &componentUnique)
+    {
+        countCall();
+        FakeComponent *c = component(componentUnique);
+        if (!c) {
+            sendErrorReply(QStringLiteral("org.kde.kglobalaccel.NoSuchComponent"), QStringLiteral("The component '%1' doesn't exist.").arg(componentUnique));
+            return QDBusObjectPath(QStringLiteral("/"));
+        }
+        return c->dbusPath();
+    }
+
+    Q_SCRIPTABLE void doRegister(const QStringList &actionId)
+    {
+        countCall();
+        registerAction(actionId);
+    }
+
+    Q_SCRIPTABLE void setInactive(const QStringList &actionId)
+    {
+        countCall();
+        if (GlobalShortcut *sc = shortcut(actionId)) {
+            sc->isPresent = false;
+        }
+    }
+
+    Q_SCRIPTABLE bool unregister(const QString &componentUnique, const QString &shortcutUnique)
+    {
+        countCall();
+        FakeComponent *c = component(componentUnique);
+        return c && c->shortcuts.remove(shortcutUnique) > 0;
+    }
+
+    Q_SCRIPTABLE QList<QKeySequence> shortcutKeys(const QStringList &actionId)
+    {
+        countCall();
+        GlobalShortcut *sc = shortcut(actionId);
+        return sc ? sc->keys : QList<QKeySequence>();
+    }
+
+    Q_SCRIPTABLE QList<QKeySequence> defaultShortcutKeys(const QStringList &actionId)
+    {
+        countCall();
+        GlobalShortcut *sc = shortcut(actionId);
+        return sc ? sc->defaultKeys : QList<QKeySequence>();
+    }
+
+    Q_SCRIPTABLE QList<QKeySequence> setShortcutKeys(const QStringList &actionId, const QList<QKeySequence> &keys, uint flags)
+    {
+        countCall();
+        return setKeys(actionId, keys, flags);
+    }
+
+    Q_SCRIPTABLE QList<QList<QKeySequence>>
+    setShortcutKeysBatch(const QList<QStringList> &actionIds, const QList<QList<QKeySequence>> &keys, const QList<uint> &flags)
+    {
+        countCall();
+        QList<QList<QKeySequence>> results;
+        if (actionIds.size() != keys.size() || actionIds.size() != flags.size()) {
+            sendErrorReply(QDBusError::InvalidArgs, QStringLiteral("Mismatching argument lengths"));
+            return results;
+        }
+        results.reserve(actionIds.size());
+        for (qsizetype i = 0; i < actionIds.size(); ++i) {
+            registerAction(actionIds.at(i));
+            results.append(setKeys(actionIds.at(i), keys.at(i), flags.at(i)));
+        }
+        return results;
+    }
+
+    Q_SCRIPTABLE QList<KGlobalShortcutInfo> shortcutInfos(const QString &componentUnique, const QString &context, uint offset, uint limit)
+    {
+        countCall();
+        return collectInfos(componentUnique, context, offset, limit);
+    }
+
+    Q_SCRIPTABLE KGlobalShortcutInfoTable shortcutInfoTable(const QString &componentUnique, const QString &context, uint offset, uint limit)
+    {
+        countCall();
+        if (!infoTablesSupported) {
+            sendErrorReply(QDBusError::UnknownMethod, QStringLiteral("No such method 'shortcutInfoTable'"));
+            return {};
+        }
+        return KGlobalShortcutInfoTable(collectInfos(componentUnique, context, offset, limit));
+    }
+
+    Q_SCRIPTABLE void setForeignShortcutKeys(const QStringList &actionId, const QList<QKeySequence> &keys)
+    {
+        countCall();
+        if (GlobalShortcut *sc = shortcut(actionId)) {
+            sc->keys = keys;
+            sc->isFresh = false;
+            Q_EMIT yourShortcutsChanged(actionId, keys);
+        }
+    }
+
+    Q_SCRIPTABLE QList<KGlobalShortcutInfo> globalShortcutsByKey(const QKeySequence &key, KGlobalAccel::MatchType type)
+    {
+        countCall();
+        return infosByKey(key, type);
+    }
+
+    Q_SCRIPTABLE KGlobalShortcutInfoTable globalShortcutsByKeyTable(const QKeySequence &key, KGlobalAccel::MatchType type)
+    {
+        countCall();
+        if (!infoTablesSupported) {
+            sendErrorReply(QDBusError::UnknownMethod, QStringLiteral("No such method 'globalShortcutsByKeyTable'"));
+            return {};
+        }
+        return KGlobalShortcutInfoTable(infosByKey(key, type));
+    }
+
+    Q_SCRIPTABLE bool globalShortcutAvailable(const QKeySequence &key, const QString &component)
+    {
+        countCall();
+        Q_UNUSED(component)
+        return !isKeyTaken(key, nullptr);
+    }
+
+    Q_SCRIPTABLE bool setInverseShortcutActions(const QString &componentUnique, const QString &forwardActionUnique, const QString &backwardActionUnique, uint flags)
+    {
+        countCall();
+        Q_UNUSED(flags)
+        return shortcut(componentUnique, forwardActionUnique) && shortcut(componentUnique, backwardActionUnique);
+    }
+
+    Q_SCRIPTABLE void blockGlobalShortcuts(bool block)
+    {
+        countCall();
+        Q_UNUSED(block)
+    }
+
+    Q_SCRIPTABLE void activateGlobalShortcutContext(const QString &component, const QString &context)
+    {
+        countCall();
+        Q_UNUSED(component)
+        Q_UNUSED(context)
+    }
+
+Q_SIGNALS:
+    Q_SCRIPTABLE void yourShortcutsChanged(const QStringList &actionId, const QList<QKeySequence> &newKeys);
+
+private:
+    QList<KGlobalShortcutInfo> collectInfos(const QString &componentUnique, const QString &context, uint offset, uint limit) const
+    {
+        QList<KGlobalShortcutInfo> infos;
+        // There is only the default context
+        if (!context.isEmpty() && context != QLatin1String("default")) {
+            return infos;
+        }
+        QStringList componentNames = m_components.keys();
+        componentNames.sort();
+        uint index = 0;
+        for (const QString &name : std::as_const(componentNames)) {
+            if (!componentUnique.isEmpty() && name != componentUnique) {
+                continue;
+            }
+            const FakeComponent *component = m_components.value(name);
+            for (const GlobalShortcut &sc : std::as_const(component->shortcuts)) {
+                if (index++ < offset) {
+                    continue;
+                }
+                if (uint(infos.size()) == limit) {
+                    return infos;
+                }
+                infos.append(sc.info(component));
+            }
+        }
+        return infos;
+    }
+
+    QList<KGlobalShortcutInfo> infosByKey(const QKeySequence &key, KGlobalAccel::MatchType type) const
+    {
+        QList<KGlobalShortcutInfo> infos;
+        if (type != KGlobalAccel::Equal) {
+            // Only exact matches are emulated
+            return infos;
+        }
+        for (FakeComponent *component : std::as_const(m_components)) {
+            for (const GlobalShortcut &sc : std::as_const(component->shortcuts)) {
+                if (sc.keys.contains(key)) {
+                    infos.append(sc.info(component));
+                }
+            }
+        }
+        return infos;
+    }
+
+    void registerAction(const QStringList &actionId)
+    {
+        if (actionId.size() < 4) {
+            return;
+        }
+        const QString &componentUnique = actionId.at(KGlobalAccel::ComponentUnique);
+        FakeComponent *c = component(componentUnique);
+        if (!c) {
+            c = new FakeComponent(componentUnique, actionId.at(KGlobalAccel::ComponentFriendly), this);
+            m_components.insert(componentUnique, c);
+            if (m_connection) {
+                m_connection->registerObject(c->dbusPath().path(), c, QDBusConnection::ExportScriptableContents);
+            }
+        } else if (!actionId.at(KGlobalAccel::ComponentFriendly).isEmpty()) {
+            c->setFriendlyName(actionId.at(KGlobalAccel::ComponentFriendly));
+        }
+
+        GlobalShortcut &sc = c->shortcuts[actionId.at(KGlobalAccel::ActionUnique)];
+        sc.uniqueName = actionId.at(KGlobalAccel::ActionUnique);
+        if (!actionId.at(KGlobalAccel::ActionFriendly).isEmpty()) {
+            sc.friendlyName = actionId.at(KGlobalAccel::ActionFriendly);
+        }
+    }
+
+    bool isKeyTaken(const QKeySequence &key, const GlobalShortcut *except) const
+    {
+        for (FakeComponent *component : std::as_const(m_components)) {
+            for (const GlobalShortcut &sc : std::as_const(component->shortcuts)) {
+                if (&sc != except && sc.keys.contains(key)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    QList<QKeySequence> setKeys(const QStringList &actionId, const QList<QKeySequence> &keys, uint flags)
+    {
+        GlobalShortcut *sc = shortcut(actionId);
+        if (!sc) {
+            return {};
+        }
+
+        if (flags & IsDefault) {
+            sc->defaultKeys = keys;
+            return keys;
+        }
+
+        if (flags & SetPresent) {
+            sc->isPresent = true;
+        }
+
+        // Autoloading keeps whatever was assigned before
+        if (!(flags & NoAutoloading) && !sc->isFresh) {
+            return sc->keys;
+        }
+
+        // Keys used by other actions are dropped, that's how clashes are resolved
+        QList<QKeySequence> assigned;
+        for (const QKeySequence &key : keys) {
+            if (key.isEmpty() || !isKeyTaken(key, sc)) {
+                assigned.append(key);
+            }
+        }
+        sc->keys = assigned;
+        sc->isFresh = false;
+        return assigned;
+    }
+
+    QString m_address;
+    int m_generation = 0;
+    std::unique_ptr<QDBusConnection> m_connection;
+    QHash<QString, FakeComponent *> m_components;
+};
+
+FakeKGlobalAccelDaemon::FakeKGlobalAccelDaemon(QObject *parent)
+    : QObject(parent)
+{
+    qDBusRegisterMetaType<QList<int>>();
+    qDBusRegisterMetaType<QKeySequence>();
+    qDBusRegisterMetaType<QList<QKeySequence>>();
+    qDBusRegisterMetaType<QList<QList<QKeySequence>>>();
+    qDBusRegisterMetaType<QList<QStringList>>();
+    qDBusRegisterMetaType<KGlobalShortcutInfo>();
+    qDBusRegisterMetaType<QList<KGlobalShortcutInfo>>();
+    qDBusRegisterMetaType<KGlobalAccel::MatchType>();
+    KGlobalShortcutInfoTable::registerMetaTypes();
+}
+
+FakeKGlobalAccelDaemon::~FakeKGlobalAccelDaemon()
+{
+    if (m_service) {
+        QMetaObject::invokeMethod(
+            m_service,
+            [this] {
+                m_service->disconnectFromBus();
+            },
+            Qt::BlockingQueuedConnection);
+        // Deleted by the daemon thread when it finishes
+        m_service->deleteLater();
+        m_service = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+    }
+
+    QDBusConnection::disconnectFromBus(QStringLiteral("kglobalacceld"));
+
+    if (m_bus) {
+        m_bus->kill();
+        m_bus->waitForFinished();
+    }
+    if (!sessionBusSocket().isEmpty()) {
+        QFile::remove(sessionBusSocket());
+    }
+}
+
+void FakeKGlobalAccelDaemon::useAsSessionBus()
+{
+    sessionBusSocket() = QDir::temp().filePath(QStringLiteral("fakekglobalacceld-%1").arg(QCoreApplication::applicationPid()));
+    qputenv("DBUS_SESSION_BUS_ADDRESS", "unix:path=" + QFile::encodeName(sessionBusSocket()));
+}
+
+bool FakeKGlobalAccelDaemon::start()
+{
+    const QString dbusDaemon = QStandardPaths::findExecutable(QStringLiteral("dbus-daemon"));
+    if (dbusDaemon.isEmpty()) {
+        qWarning() << "dbus-daemon not found";
+        return false;
+    }
+
+    // Like a session bus, but without the service files of the system so that the real
+    // kglobalacceld can't be activated on it
+    m_busConfig = new QTemporaryFile(this);
+    if (!m_busConfig->open()) {
+        qWarning() << "Failed to write the configuration of the private dbus-daemon" << m_busConfig->errorString();
+        return false;
+    }
+    QByteArray listen = QByteArrayLiteral("unix:tmpdir=/tmp");
+    if (!sessionBusSocket().isEmpty()) {
+        // A socket left behind by an earlier process with the same pid
+        QFile::remove(sessionBusSocket());
+        listen = "unix:path=" + QFile::encodeName(sessionBusSocket());
+    }
+    m_busConfig->write(
+        "<!DOCTYPE busconfig PUBLIC \"-//freedesktop//DTD D-Bus Bus Configuration 1.0//EN\"\n"
+        " \"http://www.freedesktop.org/standards/dbus/1.0/busconfig.dtd\">\n"
+        "<busconfig>\n"
+        "  <type>session</type>\n"
+        "  <listen>"
+        + listen
+        + "</listen>\n"
+        "  <auth>EXTERNAL</auth>\n"
+        "  <policy context=\"default\">\n"
+        "    <allow send_destination=\"*\" eavesdrop=\"true\"/>\n"
+        "    <allow eavesdrop=\"true\"/>\n"
+        "    <allow own=\"*\"/>\n"
+        "  </policy>\n"
+        "</busconfig>\n");
+    m_busConfig->flush();
+
+    m_bus = new QProcess(this);
+    m_bus->start(dbusDaemon,
+                 {QStringLiteral("--config-file=%1").arg(m_busConfig->fileName()),
+                  QStringLiteral("--nofork"),
+                  QStringLiteral("--nopidfile"),
+                  QStringLiteral("--print-address")});
+    if (!m_bus->waitForStarted()) {
+        qWarning() << "Failed to start a private dbus-daemon" << m_bus->errorString();
+        return false;
+    }
+    while (!m_bus->canReadLine()) {
+        if (!m_bus->waitForReadyRead()) {
+            qWarning() << "The private dbus-daemon didn't print its address" << m_bus->errorString();
+            return false;
+        }
+    }
+    m_address = QString::fromLocal8Bit(m_bus->readLine()).trimmed();
+
+    m_thread = new QThread;
+    m_thread->setObjectName(QStringLiteral("fakekglobalacceld"));
+    m_thread->start();
+
+    m_service = new FakeKGlobalAccelService(m_address);
+    m_service->moveToThread(m_thread);
+
+    bool registered = false;
+    QMetaObject::invokeMethod(
+        m_service,
+        [this, &registered] {
+            registered = m_service->connectToBus();
+        },
+        Qt::BlockingQueuedConnection);
+    if (!registered) {
+        return false;
+    }
+
+    return QDBusConnection::connectToBus(m_address, QStringLiteral("kglobalacceld")).isConnected();
+}
+
+QString FakeKGlobalAccelDaemon::busAddress() const
+{
+    return m_address;
+}
+
+QDBusConnection FakeKGlobalAccelDaemon::clientConnection() const
+{
+    return QDBusConnection(QStringLiteral("kglobalacceld"));
+}
+
+void FakeKGlobalAccelDaemon::press(const QString &componentUnique, const QString &actionUnique, qlonglong timestamp)
+{
+    QMetaObject::invokeMethod(
+        m_service,
+        [=, this] {
+            if (FakeComponent *c = m_service->component(componentUnique)) {
+                Q_EMIT c->globalShortcutPressed(componentUnique, actionUnique, timestamp);
+            }
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+void FakeKGlobalAccelDaemon::repeat(const QString &componentUnique, const QString &actionUnique, qlonglong timestamp)
+{
+    QMetaObject::invokeMethod(
+        m_service,
+        [=, this] {
+            if (FakeComponent *c = m_service->component(componentUnique)) {
+                Q_EMIT c->globalShortcutRepeated(componentUnique, actionUnique, timestamp);
+            }
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+void FakeKGlobalAccelDaemon::release(const QString &componentUnique, const QString &actionUnique, qlonglong timestamp)
+{
+    QMetaObject::invokeMethod(
+        m_service,
+        [=, this] {
+            if (FakeComponent *c = m_service->component(componentUnique)) {
+                Q_EMIT c->globalShortcutReleased(componentUnique, actionUnique, timestamp);
+            }
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+void FakeKGlobalAccelDaemon::restart()
+{
+    QMetaObject::invokeMethod(
+        m_service,
+        [this] {
+            m_service->disconnectFromBus();
+            m_service->forgetPresence();
+            // A new connection gets a new unique name, so clients see the owner change
+            m_service->connectToBus();
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+void FakeKGlobalAccelDaemon::stop()
+{
+    QMetaObject::invokeMethod(
+        m_service,
+        [this] {
+            m_service->disconnectFromBus();
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+void FakeKGlobalAccelDaemon::resume()
+{
+    QMetaObject::invokeMethod(
+        m_service,
+        [this] {
+            m_service->connectToBus();
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+void FakeKGlobalAccelDaemon::setReplyDelay(std::chrono::milliseconds delay)
+{
+    QMetaObject::invokeMethod(
+        m_service,
+        [this, delay] {
+            m_service->replyDelay = delay;
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+void FakeKGlobalAccelDaemon::setInfoTablesSupported(bool supported)
+{
+    QMetaObject::invokeMethod(
+        m_service,
+        [this, supported] {
+            m_service->infoTablesSupported = supported;
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+bool FakeKGlobalAccelDaemon::isRegistered(const QString &componentUnique, const QString &actionUnique) const
+{
+    bool registered = false;
+    QMetaObject::invokeMethod(
+        m_service,
+        [&] {
+            registered = m_service->shortcut(componentUnique, actionUnique);
+        },
+        Qt::BlockingQueuedConnection);
+    return registered;
+}
+
+bool FakeKGlobalAccelDaemon::isPresent(const QString &componentUnique, const QString &actionUnique) const
+{
+    bool present = false;
+    QMetaObject::invokeMethod(
+        m_service,
+        [&] {
+            const GlobalShortcut *sc = m_service->shortcut(componentUnique, actionUnique);
+            present = sc && sc->isPresent;
+        },
+        Qt::BlockingQueuedConnection);
+    return present;
+}
+
+QList<QKeySequence> FakeKGlobalAccelDaemon::keys(const QString &componentUnique, const QString &actionUnique) const
+{
+    QList<QKeySequence> keys;
+    QMetaObject::invokeMethod(
+        m_service,
+        [&] {
+            if (const GlobalShortcut *sc = m_service->shortcut(componentUnique, actionUnique)) {
+                keys = sc->keys;
+            }
+        },
+        Qt::BlockingQueuedConnection);
+    return keys;
+}
+
+QList<QKeySequence> FakeKGlobalAccelDaemon::defaultKeys(const QString &componentUnique, const QString &actionUnique) const
+{
+    QList<QKeySequence> keys;
+    QMetaObject::invokeMethod(
+        m_service,
+        [&] {
+            if (const GlobalShortcut *sc = m_service->shortcut(componentUnique, actionUnique)) {
+                keys = sc->defaultKeys;
+            }
+        },
+        Qt::BlockingQueuedConnection);
+    return keys;
+}
+
+QString FakeKGlobalAccelDaemon::friendlyName(const QString &componentUnique, const QString &actionUnique) const
+{
+    QString name;
+    QMetaObject::invokeMethod(
+        m_service,
+        [&] {
+            if (const GlobalShortcut *sc = m_service->shortcut(componentUnique, actionUnique)) {
+                name = sc->friendlyName;
+            }
+        },
+        Qt::BlockingQueuedConnection);
+    return name;
+}
+
+QString FakeKGlobalAccelDaemon::componentFriendlyName(const QString &componentUnique) const
+{
+    QString name;
+    QMetaObject::invokeMethod(
+        m_service,
+        [&] {
+            if (const FakeComponent *c = m_service->component(componentUnique)) {
+                name = c->friendlyName();
+            }
+        },
+        Qt::BlockingQueuedConnection);
+    return name;
+}
+
+int FakeKGlobalAccelDaemon::presentCount(const QString &componentUnique) const
+{
+    int count = 0;
+    QMetaObject::invokeMethod(
+        m_service,
+        [&] {
+            if (const FakeComponent *c = m_service->component(componentUnique)) {
+                count = std::count_if(c->shortcuts.cbegin(), c->shortcuts.cend(), [](const GlobalShortcut &shortcut) {
+                    return shortcut.isPresent;
+                });
+            }
+        },
+        Qt::BlockingQueuedConnection);
+    return count;
+}
+
+void FakeKGlobalAccelDaemon::changeKeys(const QString &componentUnique, const QString &actionUnique, const QList<QKeySequence> &keys)
+{
+    QMetaObject::invokeMethod(
+        m_service,
+        [&] {
+            m_service->changeKeys(componentUnique, actionUnique, keys);
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+int FakeKGlobalAccelDaemon::callCount(const QString &method) const
+{
+    QMutexLocker locker(&m_service->callCountsMutex);
+    return m_service->callCounts.value(method);
+}
+
+void FakeKGlobalAccelDaemon::resetCallCounts()
+{
+    QMutexLocker locker(&m_service->callCountsMutex);
+    m_service->callCounts.clear();
+}
+
+#include "fakekglobalacceld.moc"
+#include "moc_fakekglobalacceld.cpp"
@@ -0,0 +1,99 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef FAKEKGLOBALACCELD_H
+#define FAKEKGLOBALACCELD_H
+
+#include <QDBusConnection>
+#include <QKeySequence>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include <chrono>
+
+class QProcess;
+class QTemporaryFile;
+class QThread;
+class FakeKGlobalAccelService;
+
+/*
+ * A stand-in for kglobalacceld to test KGlobalAccel without a desktop session.
+ *
+ * start() launches a private dbus-daemon, registers the fake daemon there as org.kde.kglobalaccel
+ * and opens the "kglobalacceld" connection to that bus, which KGlobalAccel prefers over the
+ * session bus. It therefore has to be called before KGlobalAccel::self() is used for the first time.
+ *
+ * The daemon serves org.kde.KGlobalAccel and org.kde.kglobalaccel.Component from its own thread,
+ * so blocking calls made by KGlobalAccel in the test thread don't dead lock. All methods of this
+ * class are meant to be called from the test thread and wait for the daemon thread.
+ */
+class FakeKGlobalAccelDaemon : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FakeKGlobalAccelDaemon(QObject *parent = nullptr);
+    ~FakeKGlobalAccelDaemon() override;
+
+    /// Makes the private bus the session bus of this process. Must be called before anything
+    /// connects to the session bus, i.e. before the application object is created.
+    static void useAsSessionBus();
+
+    /// Returns false if no private bus could be started, tests should be skipped then
+    bool start();
+
+    QString busAddress() const;
+
+    /// The connection KGlobalAccel uses
+    QDBusConnection clientConnection() const;
+
+    void press(const QString &componentUnique, const QString &actionUnique, qlonglong timestamp = 0);
+    void repeat(const QString &componentUnique, const QString &actionUnique, qlonglong timestamp = 0);
+    void release(const QString &componentUnique, const QString &actionUnique, qlonglong timestamp = 0);
+
+    /// Emulates kglobalacceld crashing and coming back. Shortcut keys survive as they would in the
+    /// configuration file but all actions are marked as not present anymore.
+    void restart();
+
+    /// Emulates kglobalacceld not running until resume() is called. The private bus has no
+    /// service files, so StartServiceByName fails in the meantime.
+    void stop();
+    void resume();
+
+    /// Makes the daemon sleep before answering each call, to emulate a busy kglobalacceld
+    void setReplyDelay(std::chrono::milliseconds delay);
+
+    /// Makes the daemon answer the methods returning KGlobalShortcutInfoTable with UnknownMethod,
+    /// as kglobalacceld versions without them would
+    void setInfoTablesSupported(bool supported);
+
+    bool isRegistered(const QString &componentUnique, const QString &actionUnique) const;
+    bool isPresent(const QString &componentUnique, const QString &actionUnique) const;
+    QList<QKeySequence> keys(const QString &componentUnique, const QString &actionUnique) const;
+    QList<QKeySequence> defaultKeys(const QString &componentUnique, const QString &actionUnique) const;
+    QString friendlyName(const QString &componentUnique, const QString &actionUnique) const;
+    QString componentFriendlyName(const QString &componentUnique) const;
+    /// The number of actions of @p componentUnique an application told the daemon it has
+    int presentCount(const QString &componentUnique) const;
+
+    /// Changes the keys of an action as the shortcuts settings module would
+    void changeKeys(const QString &componentUnique, const QString &actionUnique, const QList<QKeySequence> &keys);
+
+    /// How often the D-Bus method @p method was called since the last resetCallCounts()
+    int callCount(const QString &method) const;
+    void resetCallCounts();
+
+private:
+    QProcess *m_bus = nullptr;
+    QTemporaryFile *m_busConfig = nullptr;
+    QString m_address;
+    QThread *m_thread = nullptr;
+    FakeKGlobalAccelService *m_service = nullptr;
+};
+
+#endif
@@ -0,0 +1,978 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "fakekglobalacceld.h"
+
+#include <KGlobalAccel>
+#include <KGlobalAccelIpcStats>
+#include <KGlobalShortcutInfoStream>
+#include <KGlobalShortcutLatencyStats>
+#include <QAction>
+#include <QBuffer>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusReply>
+#include <QDeadlineTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QTest>
+#include <QThread>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+
+class KGlobalAccelClientTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testLazyStartup();
+    void testQueuedActivation();
+    void testRegistration();
+    void testPressAndRelease();
+    void testLatencyStats();
+    void testIpcStats();
+    void testClash();
+    void testChangedByDaemon();
+    void testCoalescedChanges();
+    void testGlobalShortcutCache();
+    void testAsynchronousQueries();
+    void testComponentQueries();
+    void testShortcutInfoStream();
+    void testBatch();
+    void testBatchRemoval();
+    void testBatchNewComponent();
+    void testAsynchronousUpdates();
+    void testAsynchronousLateReply();
+    void testRestart();
+    void testRemove();
+    void testSharedNames();
+    void testFriendlyNameChanges();
+    void testRedundantUpdates();
+    void testMultiChordInfos();
+    void testInfoTableFallback();
+    void testPrivateConnection();
+
+private:
+    QAction *createAction(const QString &name);
+
+    FakeKGlobalAccelDaemon *m_daemon = nullptr;
+};
+
+QAction *KGlobalAccelClientTest::createAction(const QString &name)
+{
+    auto action = new QAction(name, this);
+    action->setObjectName(name);
+    action->setProperty("componentName", QStringLiteral("kglobalaccelclienttest"));
+    return action;
+}
+
+void KGlobalAccelClientTest::initTestCase()
+{
+    // Restore shortcuts right after a restart instead of after a random delay
+    qputenv("KGLOBALACCEL_RESTORE_JITTER", "0");
+    m_daemon = new FakeKGlobalAccelDaemon(this);
+    if (!m_daemon->start()) {
+        QSKIP("Could not start a private D-Bus session");
+    }
+}
+
+void KGlobalAccelClientTest::testLazyStartup()
+{
+    // Runs first, so KGlobalAccel is created here
+    const QString component = QStringLiteral("kglobalaccelclienttest");
+    KGlobalAccelIpcStats stats;
+    QAction *action = createAction(QStringLiteral("lazy"));
+    QVERIFY(!KGlobalAccel::self()->hasShortcut(action));
+    QVERIFY(KGlobalAccel::self()->shortcut(action).isEmpty());
+    QCOMPARE(stats.totalCallCount(), 0);
+
+    // The first real use finds kglobalaccel running and doesn't need to start it
+    const QList<QKeySequence> keys{QKeySequence(Qt::META | Qt::CTRL | Qt::Key_F6)};
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, keys, KGlobalAccel::NoAutoloading));
+    QCOMPARE(stats.callCount(QStringLiteral("NameHasOwner")), 1);
+    QCOMPARE(stats.callCount(QStringLiteral("StartServiceByName")), 0);
+    QVERIFY(m_daemon->isRegistered(component, QStringLiteral("lazy")));
+    QCOMPARE(m_daemon->keys(component, QStringLiteral("lazy")), keys);
+
+    // Nothing is queued then, clashes are resolved before setShortcut() returns
+    QAction *second = createAction(QStringLiteral("lazySecond"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(second, keys, KGlobalAccel::NoAutoloading));
+    QVERIFY(KGlobalAccel::self()->shortcut(second).isEmpty());
+    QCOMPARE(stats.callCount(QStringLiteral("setShortcutKeysBatch")), 0);
+    QCOMPARE(stats.restartsHandled(), 0);
+
+    KGlobalAccel::self()->removeAllShortcuts(action);
+    KGlobalAccel::self()->removeAllShortcuts(second);
+}
+
+void KGlobalAccelClientTest::testQueuedActivation()
+{
+    using namespace std::chrono_literals;
+    const QString component = QStringLiteral("kglobalaccelclienttest");
+    KGlobalAccelIpcStats stats;
+    stats.reset();
+
+    // Switching connections makes KGlobalAccel look for kglobalaccel again, it isn't there this time
+    m_daemon->stop();
+    KGlobalAccel::self()->setPrivateConnection(true);
+    QCOMPARE(stats.callCount(QStringLiteral("NameHasOwner")), 1);
+    QCOMPARE(stats.callCount(QStringLiteral("StartServiceByName")), 1);
+    QCOMPARE(stats.blockedTime(QStringLiteral("StartServiceByName")), 0ns);
+
+    // What is set in the meantime is queued, setShortcut() doesn't wait for kglobalaccel
+    const QList<QKeySequence> keys{QKeySequence(Qt::META | Qt::CTRL | Qt::Key_F10)};
+    QAction *action = createAction(QStringLiteral("activation"));
+    QAction *second = createAction(QStringLiteral("activationSecond"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, keys, KGlobalAccel::NoAutoloading));
+    QVERIFY(KGlobalAccel::self()->setShortcut(second, {QKeySequence(Qt::META | Qt::CTRL | Qt::Key_F11)}, KGlobalAccel::NoAutoloading));
+    QCOMPARE(KGlobalAccel::self()->shortcut(action), keys);
+
+    // Nothing can start it on the private bus, which doesn't end the queueing
+    QTest::qWait(50);
+    QCOMPARE(stats.callCount(QStringLiteral("setShortcutKeysBatch")), 0);
+    QVERIFY(!m_daemon->isRegistered(component, QStringLiteral("activation")));
+
+    // Once kglobalaccel is there it gets everything in one go
+    m_daemon->resume();
+    QTRY_VERIFY(m_daemon->isRegistered(component, QStringLiteral("activationSecond")));
+    QCOMPARE(m_daemon->keys(component, QStringLiteral("activation")), keys);
+    QCOMPARE(stats.callCount(QStringLiteral("setShortcutKeysBatch")), 1);
+    QCOMPARE(stats.callCount(QStringLiteral("setShortcutKeys")), 0);
+    QCOMPARE(stats.callCount(QStringLiteral("doRegister")), 0);
+    // Its appearance is no restart
+    QTest::qWait(50);
+    QCOMPARE(stats.restartsHandled(), 0);
+
+    // Switching connections while waiting for kglobalaccel sends the queue once the new
+    // connection finds it
+    m_daemon->stop();
+    KGlobalAccel::self()->setPrivateConnection(false);
+    QAction *switched = createAction(QStringLiteral("activationSwitched"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(switched, {QKeySequence(Qt::META | Qt::CTRL | Qt::Key_F12)}, KGlobalAccel::NoAutoloading));
+    QTest::qWait(50);
+    QVERIFY(!m_daemon->isRegistered(component, QStringLiteral("activationSwitched")));
+    m_daemon->resume();
+    KGlobalAccel::self()->setPrivateConnection(true);
+    QTRY_VERIFY(m_daemon->isRegistered(component, QStringLiteral("activationSwitched")));
+
+    KGlobalAccel::self()->setPrivateConnection(false);
+    KGlobalAccel::self()->removeAllShortcuts(action);
+    KGlobalAccel::self()->removeAllShortcuts(second);
+    KGlobalAccel::self()->removeAllShortcuts(switched);
+}
+
+void KGlobalAccelClientTest::testRegistration()
+{
+    QAction *action = createAction(QStringLiteral("register"));
+    const QList<QKeySequence> keys{QKeySequence(Qt::META | Qt::Key_F1)};
+
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, keys, KGlobalAccel::NoAutoloading));
+    QVERIFY(KGlobalAccel::self()->hasShortcut(action));
+    QCOMPARE(KGlobalAccel::self()->shortcut(action), keys);
+
+    QVERIFY(m_daemon->isRegistered(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("register")));
+    QVERIFY(m_daemon->isPresent(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("register")));
+    QCOMPARE(m_daemon->keys(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("register")), keys);
+
+    QCOMPARE(KGlobalAccel::self()->globalShortcut(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("register")), keys);
+}
+
+void KGlobalAccelClientTest::testPressAndRelease()
+{
+    QAction *action = createAction(QStringLiteral("press"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {QKeySequence(Qt::META | Qt::Key_F2)}, KGlobalAccel::NoAutoloading));
+
+    QSignalSpy triggeredSpy(action, &QAction::triggered);
+    QSignalSpy activeSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutActiveChanged);
+
+    m_daemon->press(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("press"), 42);
+    QTRY_COMPARE(triggeredSpy.count(), 1);
+    QCOMPARE(action->property("org.kde.kglobalaccel.activationTimestamp").toLongLong(), 42);
+    QCOMPARE(activeSpy.count(), 1);
+    QCOMPARE(activeSpy.at(0).at(1).toBool(), true);
+
+    // Repeats only trigger actions that want to auto repeat
+    action->setAutoRepeat(false);
+    m_daemon->repeat(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("press"));
+    m_daemon->release(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("press"));
+    QTRY_COMPARE(activeSpy.count(), 2);
+    QCOMPARE(activeSpy.at(1).at(1).toBool(), false);
+    QCOMPARE(triggeredSpy.count(), 1);
+
+    // Disabled actions don't trigger. Signals arrive in order, so once the
+    // sentinel triggered the press of the disabled action was handled too.
+    QAction *sentinel = createAction(QStringLiteral("pressSentinel"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(sentinel, {QKeySequence(Qt::META | Qt::SHIFT | Qt::Key_F2)}, KGlobalAccel::NoAutoloading));
+    QSignalSpy sentinelSpy(sentinel, &QAction::triggered);
+
+    action->setEnabled(false);
+    m_daemon->press(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("press"));
+    m_daemon->release(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("press"));
+    m_daemon->press(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("pressSentinel"));
+    m_daemon->release(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("pressSentinel"));
+    QTRY_COMPARE(sentinelSpy.count(), 1);
+    QCOMPARE(triggeredSpy.count(), 1);
+
+    action->setEnabled(true);
+    m_daemon->press(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("press"));
+    QTRY_COMPARE(triggeredSpy.count(), 2);
+    m_daemon->release(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("press"));
+}
+
+void KGlobalAccelClientTest::testLatencyStats()
+{
+    QAction *action = createAction(QStringLiteral("measured"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {QKeySequence(Qt::META | Qt::Key_F9)}, KGlobalAccel::NoAutoloading));
+    QSignalSpy activeSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutActiveChanged);
+
+    auto stats = std::make_unique<KGlobalShortcutLatencyStats>();
+    m_daemon->press(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("measured"), 7);
+    m_daemon->release(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("measured"), 8);
+    QTRY_COMPARE(activeSpy.count(), 2);
+
+    QVERIFY(stats->components().contains(QStringLiteral("kglobalaccelclienttest")));
+    QCOMPARE(stats->actions(QStringLiteral("kglobalaccelclienttest")), QStringList{QStringLiteral("measured")});
+    QCOMPARE(stats->activationCount(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("measured")), 2);
+    const QList<int> histogram = stats->histogram(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("measured"));
+    QCOMPARE(histogram.size(), KGlobalShortcutLatencyStats::bucketBounds().size() + 1);
+    QCOMPARE(std::accumulate(histogram.cbegin(), histogram.cend(), 0), 2);
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QVERIFY(stats->writeTrace(&buffer));
+    const QJsonArray events = QJsonDocument::fromJson(buffer.data()).object().value(QStringLiteral("traceEvents")).toArray();
+    QCOMPARE(events.size(), 4);
+    QCOMPARE(events.at(0).toObject().value(QStringLiteral("name")).toString(), QStringLiteral("kglobalaccelclienttest/measured"));
+    QCOMPARE(events.at(0).toObject().value(QStringLiteral("args")).toObject().value(QStringLiteral("daemonTimestamp")).toInteger(), 7);
+
+    stats->reset();
+    QVERIFY(stats->components().isEmpty());
+
+    // The recent activations are discarded with the last stats object
+    m_daemon->press(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("measured"));
+    m_daemon->release(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("measured"));
+    QTRY_COMPARE(activeSpy.count(), 4);
+    stats.reset();
+    KGlobalShortcutLatencyStats later;
+    QBuffer laterBuffer;
+    QVERIFY(laterBuffer.open(QIODevice::WriteOnly));
+    QVERIFY(later.writeTrace(&laterBuffer));
+    QVERIFY(QJsonDocument::fromJson(laterBuffer.data()).object().value(QStringLiteral("traceEvents")).toArray().isEmpty());
+}
+
+void KGlobalAccelClientTest::testIpcStats()
+{
+    // Without a stats object calls are counted, but their arguments aren't measured
+    KGlobalAccelIpcStats().reset();
+    QAction *unmeasured = createAction(QStringLiteral("unmeasured"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(unmeasured, {QKeySequence(Qt::META | Qt::SHIFT | Qt::Key_F10)}, KGlobalAccel::NoAutoloading));
+    KGlobalAccel::self()->removeAllShortcuts(unmeasured);
+    {
+        KGlobalAccelIpcStats stats;
+        QVERIFY(stats.callCount(QStringLiteral("setShortcutKeys")) > 0);
+        QCOMPARE(stats.bytesSent(QStringLiteral("setShortcutKeys")), qint64(0));
+    }
+
+    KGlobalAccelIpcStats stats;
+    stats.reset();
+
+    QAction *action = createAction(QStringLiteral("counted"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {QKeySequence(Qt::META | Qt::Key_F10)}, KGlobalAccel::NoAutoloading));
+    QCOMPARE(stats.callCount(QStringLiteral("doRegister")), 1);
+    QCOMPARE(stats.callCount(QStringLiteral("setShortcutKeys")), 1);
+    QVERIFY(stats.bytesSent(QStringLiteral("setShortcutKeys")) > 0);
+    // Without asynchronous updates the application waits for the keys kglobalaccel assigned
+    QVERIFY(stats.blockedTime(QStringLiteral("setShortcutKeys")) > std::chrono::nanoseconds(0));
+    QCOMPARE(stats.blockedTime(QStringLiteral("doRegister")), std::chrono::nanoseconds(0));
+    QCOMPARE(stats.totalCallCount(), 2);
+
+    QSignalSpy triggeredSpy(action, &QAction::triggered);
+    m_daemon->press(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("counted"));
+    m_daemon->release(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("counted"));
+    QTRY_COMPARE(stats.signalsReceived(), 2);
+    QCOMPARE(triggeredSpy.count(), 1);
+
+    // Other processes can read the counters
+    QDBusConnection connection = m_daemon->clientConnection();
+    QVERIFY(stats.exportOnBus(connection));
+    const auto message = QDBusMessage::createMethodCall(connection.baseService(),
+                                                        QStringLiteral("/KGlobalAccelIpcStats"),
+                                                        QStringLiteral("org.kde.kglobalaccel.IpcStats"),
+                                                        QStringLiteral("snapshot"));
+    const QDBusReply<QVariantMap> reply = connection.call(message);
+    QVERIFY(reply.isValid());
+    QCOMPARE(reply.value().value(QStringLiteral("totalCalls")).toInt(), 2);
+    QCOMPARE(reply.value().value(QStringLiteral("signalsReceived")).toInt(), 2);
+    connection.unregisterObject(QStringLiteral("/KGlobalAccelIpcStats"));
+}
+
+void KGlobalAccelClientTest::testClash()
+{
+    const QKeySequence key(Qt::META | Qt::Key_F3);
+    QAction *first = createAction(QStringLiteral("clashFirst"));
+    QAction *second = createAction(QStringLiteral("clashSecond"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(first, {key}, KGlobalAccel::NoAutoloading));
+
+    QSignalSpy changedSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutChanged);
+    QSignalSpy batchSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutsChanged);
+    QVERIFY(KGlobalAccel::self()->setShortcut(second, {key}, KGlobalAccel::NoAutoloading));
+
+    QCOMPARE(KGlobalAccel::self()->shortcut(first), QList<QKeySequence>{key});
+    QCOMPARE(KGlobalAccel::self()->shortcut(second), QList<QKeySequence>());
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.at(0).at(0).value<QAction *>(), second);
+    QCOMPARE(changedSpy.at(0).at(1).value<QKeySequence>(), QKeySequence());
+    // The correction is announced like any other change by kglobalaccel
+    QCOMPARE(batchSpy.count(), 1);
+    QCOMPARE(batchSpy.at(0).at(0).value<QList<QAction *>>(), QList<QAction *>{second});
+
+    QVERIFY(!KGlobalAccel::isGlobalShortcutAvailable(key));
+    const QList<KGlobalShortcutInfo> infos = KGlobalAccel::globalShortcutsByKey(key);
+    QCOMPARE(infos.size(), 1);
+    QCOMPARE(infos.at(0).uniqueName(), QStringLiteral("clashFirst"));
+    QCOMPARE(infos.at(0).componentUniqueName(), QStringLiteral("kglobalaccelclienttest"));
+}
+
+void KGlobalAccelClientTest::testChangedByDaemon()
+{
+    QAction *action = createAction(QStringLiteral("changed"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {QKeySequence(Qt::META | Qt::Key_F4)}, KGlobalAccel::NoAutoloading));
+
+    QSignalSpy changedSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutChanged);
+    const QList<QKeySequence> newKeys{QKeySequence(Qt::META | Qt::SHIFT | Qt::Key_F4)};
+    m_daemon->changeKeys(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("changed"), newKeys);
+
+    QTRY_COMPARE(changedSpy.count(), 1);
+    QCOMPARE(KGlobalAccel::self()->shortcut(action), newKeys);
+}
+
+void KGlobalAccelClientTest::testCoalescedChanges()
+{
+    QAction *first = createAction(QStringLiteral("coalesced1"));
+    QAction *second = createAction(QStringLiteral("coalesced2"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(first, {QKeySequence(Qt::META | Qt::Key_F11)}, KGlobalAccel::NoAutoloading));
+    QVERIFY(KGlobalAccel::self()->setShortcut(second, {QKeySequence(Qt::META | Qt::Key_F12)}, KGlobalAccel::NoAutoloading));
+
+    KGlobalAccel::self()->setCoalesceShortcutChanges(true);
+    QSignalSpy changedSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutChanged);
+    QSignalSpy batchSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutsChanged);
+
+    const QList<QKeySequence> firstKeys{QKeySequence(Qt::META | Qt::ALT | Qt::Key_F11)};
+    const QList<QKeySequence> secondKeys{QKeySequence(Qt::META | Qt::ALT | Qt::Key_F12)};
+    m_daemon->changeKeys(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("coalesced1"), {QKeySequence(Qt::META | Qt::SHIFT | Qt::Key_F11)});
+    m_daemon->changeKeys(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("coalesced2"), secondKeys);
+    m_daemon->changeKeys(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("coalesced1"), firstKeys);
+
+    // Changes that arrive together are announced together, each action once with its final keys
+    const auto announcedFinalKeys = [&] {
+        return std::any_of(changedSpy.cbegin(), changedSpy.cend(), [&](const QList<QVariant> &arguments) {
+            return arguments.at(0).value<QAction *>() == first && arguments.at(1).value<QKeySequence>() == firstKeys.first();
+        });
+    };
+    QTRY_VERIFY(announcedFinalKeys());
+    QCOMPARE(KGlobalAccel::self()->shortcut(first), firstKeys);
+    QCOMPARE(KGlobalAccel::self()->shortcut(second), secondKeys);
+    int announced = 0;
+    for (const QList<QVariant> &arguments : std::as_const(batchSpy)) {
+        const auto actions = arguments.at(0).value<QList<QAction *>>();
+        QCOMPARE(QSet<QAction *>(actions.cbegin(), actions.cend()).size(), actions.size());
+        announced += actions.size();
+    }
+    QCOMPARE(changedSpy.count(), announced);
+
+    // Corrections of clashing shortcuts are coalesced too
+    changedSpy.clear();
+    batchSpy.clear();
+    QAction *clashing = createAction(QStringLiteral("coalescedClash"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(clashing, firstKeys, KGlobalAccel::NoAutoloading));
+    QCOMPARE(KGlobalAccel::self()->shortcut(clashing), QList<QKeySequence>());
+    QCOMPARE(changedSpy.count(), 0);
+    QTRY_COMPARE(batchSpy.count(), 1);
+    QCOMPARE(batchSpy.at(0).at(0).value<QList<QAction *>>(), QList<QAction *>{clashing});
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.at(0).at(0).value<QAction *>(), clashing);
+
+    KGlobalAccel::self()->setCoalesceShortcutChanges(false);
+    KGlobalAccel::self()->removeAllShortcuts(clashing);
+}
+
+void KGlobalAccelClientTest::testGlobalShortcutCache()
+{
+    QAction *action = createAction(QStringLiteral("cached"));
+    const QList<QKeySequence> keys{QKeySequence(Qt::META | Qt::Key_F5)};
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, keys, KGlobalAccel::NoAutoloading));
+
+    m_daemon->resetCallCounts();
+    QCOMPARE(KGlobalAccel::self()->globalShortcut(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("cached")), keys);
+    QCOMPARE(KGlobalAccel::self()->globalShortcut(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("cached")), keys);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("shortcutKeys")), 1);
+
+    // Changes announced by the daemon update the cache
+    QSignalSpy changedSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutChanged);
+    const QList<QKeySequence> newKeys{QKeySequence(Qt::META | Qt::SHIFT | Qt::Key_F5)};
+    m_daemon->changeKeys(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("cached"), newKeys);
+    QTRY_COMPARE(changedSpy.count(), 1);
+    QCOMPARE(KGlobalAccel::self()->globalShortcut(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("cached")), newKeys);
+
+    // So do our own changes
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, keys, KGlobalAccel::NoAutoloading));
+    QCOMPARE(KGlobalAccel::self()->globalShortcut(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("cached")), keys);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("shortcutKeys")), 1);
+}
+
+void KGlobalAccelClientTest::testAsynchronousQueries()
+{
+    QAction *action = createAction(QStringLiteral("queried"));
+    const QKeySequence key(Qt::META | Qt::Key_F7);
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {key}, KGlobalAccel::NoAutoloading));
+
+    QFuture<QList<KGlobalShortcutInfo>> infos = KGlobalAccel::globalShortcutsByKeyAsync(key);
+    QFuture<bool> taken = KGlobalAccel::isGlobalShortcutAvailableAsync(key);
+    QFuture<bool> available = KGlobalAccel::isGlobalShortcutAvailableAsync(QKeySequence(Qt::META | Qt::SHIFT | Qt::Key_F7));
+    QFuture<bool> active = KGlobalAccel::isComponentActiveAsync(QStringLiteral("kglobalaccelclienttest"));
+    QFuture<bool> missing = KGlobalAccel::isComponentActiveAsync(QStringLiteral("nosuchcomponent"));
+
+    // Nothing was answered yet, the queries run concurrently
+    QVERIFY(!infos.isFinished());
+
+    QTRY_VERIFY(infos.isFinished());
+    QCOMPARE(infos.result().size(), 1);
+    QCOMPARE(infos.result().constFirst().uniqueName(), QStringLiteral("queried"));
+    QTRY_VERIFY(taken.isFinished());
+    QVERIFY(!taken.result());
+    QTRY_VERIFY(available.isFinished());
+    QVERIFY(available.result());
+    QTRY_VERIFY(active.isFinished());
+    QVERIFY(active.result());
+    QTRY_VERIFY(missing.isFinished());
+    QVERIFY(!missing.result());
+
+    // The answer to a cancelled query is dropped
+    QFuture<QList<KGlobalShortcutInfo>> cancelled = KGlobalAccel::globalShortcutsByKeyAsync(key);
+    cancelled.cancel();
+    QTRY_VERIFY(cancelled.isFinished());
+    QVERIFY(cancelled.isCanceled());
+    QCOMPARE(cancelled.resultCount(), 0);
+}
+
+void KGlobalAccelClientTest::testComponentQueries()
+{
+    // A component the application no longer has actions in
+    QAction *action = createAction(QStringLiteral("foreign"));
+    action->setProperty("componentName", QStringLiteral("kglobalaccelforeigntest"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {QKeySequence(Qt::META | Qt::Key_F8)}, KGlobalAccel::NoAutoloading));
+    KGlobalAccel::self()->removeAllShortcuts(action);
+
+    m_daemon->resetCallCounts();
+    QVERIFY(KGlobalAccel::isComponentActive(QStringLiteral("kglobalaccelclienttest")));
+    QVERIFY(KGlobalAccel::isComponentActive(QStringLiteral("kglobalaccelclienttest")));
+    QVERIFY(!KGlobalAccel::isComponentActive(QStringLiteral("kglobalaccelforeigntest")));
+    QVERIFY(!KGlobalAccel::isComponentActive(QStringLiteral("kglobalaccelforeigntest")));
+    QVERIFY(!KGlobalAccel::isComponentActive(QStringLiteral("nosuchcomponent")));
+
+    // Each path is looked up once, a component that doesn't exist every time. The path of our own
+    // component is known since testAsynchronousQueries().
+    QCOMPARE(m_daemon->callCount(QStringLiteral("getComponent")), 2);
+    QVERIFY(!KGlobalAccel::isComponentActive(QStringLiteral("nosuchcomponent")));
+    QCOMPARE(m_daemon->callCount(QStringLiteral("getComponent")), 3);
+}
+
+void KGlobalAccelClientTest::testShortcutInfoStream()
+{
+    QStringList names;
+    for (const QString &name : {QStringLiteral("listed1"), QStringLiteral("listed2"), QStringLiteral("listed3")}) {
+        QAction *action = createAction(name);
+        action->setProperty("componentName", QStringLiteral("kglobalaccelstreamtest"));
+        QVERIFY(KGlobalAccel::self()->setShortcut(action, {}, KGlobalAccel::NoAutoloading));
+        names.append(name);
+    }
+
+    KGlobalShortcutInfoStream stream;
+    stream.setComponent(QStringLiteral("kglobalaccelstreamtest"));
+    stream.setPageSize(2);
+    QSignalSpy pageSpy(&stream, &KGlobalShortcutInfoStream::pageReady);
+    QSignalSpy finishedSpy(&stream, &KGlobalShortcutInfoStream::finished);
+    m_daemon->resetCallCounts();
+    stream.start();
+    QVERIFY(stream.isRunning());
+
+    QVERIFY(finishedSpy.wait());
+    QVERIFY(!stream.isRunning());
+    QVERIFY(stream.errorString().isEmpty());
+    QCOMPARE(pageSpy.count(), 2);
+    QStringList listed;
+    for (const QList<QVariant> &arguments : std::as_const(pageSpy)) {
+        const auto infos = arguments.at(0).value<QList<KGlobalShortcutInfo>>();
+        QVERIFY(infos.size() <= 2);
+        // The component names were sent once and are shared by all infos of a page
+        if (infos.size() == 2) {
+            QCOMPARE(infos.at(0).componentUniqueName().constData(), infos.at(1).componentUniqueName().constData());
+        }
+        for (const KGlobalShortcutInfo &info : infos) {
+            QCOMPARE(info.componentUniqueName(), QStringLiteral("kglobalaccelstreamtest"));
+            listed.append(info.uniqueName());
+        }
+    }
+    QCOMPARE(listed, names);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("shortcutInfoTable")), 2);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("shortcutInfos")), 0);
+
+    // A cancelled stream stays quiet
+    pageSpy.clear();
+    finishedSpy.clear();
+    stream.start();
+    stream.cancel();
+    QVERIFY(!finishedSpy.wait(200));
+    QCOMPARE(pageSpy.count(), 0);
+}
+
+void KGlobalAccelClientTest::testBatch()
+{
+    m_daemon->resetCallCounts();
+
+    KGlobalAccel::self()->beginBatch();
+    QList<QAction *> actions;
+    for (int i = 0; i < 10; ++i) {
+        QAction *action = createAction(QStringLiteral("batch%1").arg(i));
+        QVERIFY(KGlobalAccel::setGlobalShortcut(action, QKeySequence(Qt::META | Qt::ALT | Qt::Key(Qt::Key_A + i))));
+        actions.append(action);
+    }
+    // Nothing is sent before the batch is committed
+    QVERIFY(!m_daemon->isRegistered(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("batch0")));
+    KGlobalAccel::self()->commitBatch();
+
+    QCOMPARE(m_daemon->callCount(QStringLiteral("setShortcutKeysBatch")), 1);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("setShortcutKeys")), 0);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("doRegister")), 0);
+
+    for (int i = 0; i < actions.size(); ++i) {
+        const QList<QKeySequence> keys{QKeySequence(Qt::META | Qt::ALT | Qt::Key(Qt::Key_A + i))};
+        QCOMPARE(m_daemon->keys(QStringLiteral("kglobalaccelclienttest"), actions.at(i)->objectName()), keys);
+        QCOMPARE(m_daemon->defaultKeys(QStringLiteral("kglobalaccelclienttest"), actions.at(i)->objectName()), keys);
+        QCOMPARE(KGlobalAccel::self()->shortcut(actions.at(i)), keys);
+    }
+}
+
+void KGlobalAccelClientTest::testBatchRemoval()
+{
+    const QString component = QStringLiteral("kglobalaccelclienttest");
+    m_daemon->resetCallCounts();
+
+    KGlobalAccel::self()->beginBatch();
+    QAction *kept = createAction(QStringLiteral("batchKept"));
+    QAction *removed = createAction(QStringLiteral("batchRemoved"));
+    QAction *destroyed = createAction(QStringLiteral("batchDestroyed"));
+    QVERIFY(KGlobalAccel::setGlobalShortcut(kept, QKeySequence(Qt::META | Qt::ALT | Qt::Key_1)));
+    QVERIFY(KGlobalAccel::setGlobalShortcut(removed, QKeySequence(Qt::META | Qt::ALT | Qt::Key_2)));
+    QVERIFY(KGlobalAccel::setGlobalShortcut(destroyed, QKeySequence(Qt::META | Qt::ALT | Qt::Key_3)));
+    KGlobalAccel::self()->removeAllShortcuts(removed);
+    delete destroyed;
+    KGlobalAccel::self()->commitBatch();
+
+    // The daemon never heard of the actions removed before the batch was sent
+    QCOMPARE(m_daemon->callCount(QStringLiteral("setShortcutKeysBatch")), 1);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("unregister")), 0);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("setInactive")), 0);
+    QVERIFY(m_daemon->isRegistered(component, QStringLiteral("batchKept")));
+    QVERIFY(!m_daemon->isRegistered(component, QStringLiteral("batchRemoved")));
+    QVERIFY(!m_daemon->isRegistered(component, QStringLiteral("batchDestroyed")));
+
+    KGlobalAccel::self()->removeAllShortcuts(kept);
+}
+
+void KGlobalAccelClientTest::testBatchNewComponent()
+{
+    // The component only exists once the batch was sent, its changes have to arrive nonetheless
+    const QString component = QStringLiteral("kglobalaccelclienttest-batch");
+    QAction *action = createAction(QStringLiteral("batchComponent"));
+    action->setProperty("componentName", component);
+
+    KGlobalAccel::self()->beginBatch();
+    QVERIFY(KGlobalAccel::setGlobalShortcut(action, QKeySequence(Qt::META | Qt::ALT | Qt::Key_F1)));
+    KGlobalAccel::self()->commitBatch();
+    QVERIFY(m_daemon->isRegistered(component, QStringLiteral("batchComponent")));
+
+    QSignalSpy changedSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutChanged);
+    const QList<QKeySequence> newKeys{QKeySequence(Qt::META | Qt::SHIFT | Qt::Key_F1)};
+    m_daemon->changeKeys(component, QStringLiteral("batchComponent"), newKeys);
+    QTRY_COMPARE(changedSpy.count(), 1);
+    QCOMPARE(KGlobalAccel::self()->shortcut(action), newKeys);
+
+    QSignalSpy triggeredSpy(action, &QAction::triggered);
+    m_daemon->press(component, QStringLiteral("batchComponent"));
+    QTRY_COMPARE(triggeredSpy.count(), 1);
+    m_daemon->release(component, QStringLiteral("batchComponent"));
+
+    KGlobalAccel::self()->removeAllShortcuts(action);
+}
+
+void KGlobalAccelClientTest::testAsynchronousUpdates()
+{
+    const QKeySequence key(Qt::META | Qt::Key_F5);
+    QAction *first = createAction(QStringLiteral("asyncFirst"));
+    QAction *second = createAction(QStringLiteral("asyncSecond"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(first, {key}, KGlobalAccel::NoAutoloading));
+
+    KGlobalAccel::self()->setAsynchronousUpdates(true);
+    QSignalSpy changedSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutChanged);
+    QVERIFY(KGlobalAccel::self()->setShortcut(second, {key}, KGlobalAccel::NoAutoloading));
+
+    // The clash is only known once the daemon answered
+    QCOMPARE(KGlobalAccel::self()->shortcut(second), QList<QKeySequence>{key});
+    QTRY_COMPARE(changedSpy.count(), 1);
+    QCOMPARE(KGlobalAccel::self()->shortcut(second), QList<QKeySequence>());
+
+    KGlobalAccel::self()->setAsynchronousUpdates(false);
+}
+
+void KGlobalAccelClientTest::testAsynchronousLateReply()
+{
+    using namespace std::chrono_literals;
+    const QString component = QStringLiteral("kglobalaccelclienttest");
+    const QKeySequence taken(Qt::META | Qt::Key_F6);
+    const QList<QKeySequence> free{QKeySequence(Qt::META | Qt::SHIFT | Qt::Key_F6)};
+    QAction *first = createAction(QStringLiteral("lateFirst"));
+    QAction *second = createAction(QStringLiteral("lateSecond"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(first, {taken}, KGlobalAccel::NoAutoloading));
+
+    KGlobalAccelIpcStats stats;
+    stats.reset();
+    KGlobalAccel::self()->setAsynchronousUpdates(true);
+    m_daemon->setReplyDelay(50ms);
+    QSignalSpy changedSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutChanged);
+
+    // The clash is answered only after the action got other keys
+    QVERIFY(KGlobalAccel::self()->setShortcut(second, {taken}, KGlobalAccel::NoAutoloading));
+    QTRY_COMPARE(stats.callCount(QStringLiteral("setShortcutKeysBatch")), 1);
+    QVERIFY(KGlobalAccel::self()->setShortcut(second, free, KGlobalAccel::NoAutoloading));
+    QTRY_COMPARE(stats.callCount(QStringLiteral("setShortcutKeysBatch")), 2);
+    QCOMPARE(stats.blockedTime(QStringLiteral("setShortcutKeysBatch")), std::chrono::nanoseconds(0));
+
+    QTRY_COMPARE(m_daemon->keys(component, QStringLiteral("lateSecond")), free);
+    QTest::qWait(150);
+    // The late answer to the first update doesn't replace the newer keys
+    QCOMPARE(KGlobalAccel::self()->shortcut(second), free);
+    QCOMPARE(changedSpy.count(), 0);
+
+    m_daemon->setReplyDelay(0ms);
+    KGlobalAccel::self()->setAsynchronousUpdates(false);
+    KGlobalAccel::self()->removeAllShortcuts(first);
+    KGlobalAccel::self()->removeAllShortcuts(second);
+}
+
+void KGlobalAccelClientTest::testRestart()
+{
+    QAction *action = createAction(QStringLiteral("restart"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {QKeySequence(Qt::META | Qt::Key_F6)}, KGlobalAccel::NoAutoloading));
+    QVERIFY(m_daemon->isPresent(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("restart")));
+
+    QSignalSpy restoredSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutsRestored);
+    m_daemon->resetCallCounts();
+    m_daemon->restart();
+    QVERIFY(!m_daemon->isPresent(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("restart")));
+    QVERIFY(restoredSpy.wait());
+    QVERIFY(m_daemon->isPresent(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("restart")));
+    QCOMPARE(KGlobalAccel::self()->shortcut(action), QList<QKeySequence>{QKeySequence(Qt::META | Qt::Key_F6)});
+
+    // All actions of the component are restored with a single call
+    QCOMPARE(m_daemon->callCount(QStringLiteral("setShortcutKeysBatch")), 1);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("setShortcutKeys")), 0);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("doRegister")), 0);
+
+    // Shortcut signals are delivered from the new instance
+    QSignalSpy triggeredSpy(action, &QAction::triggered);
+    m_daemon->press(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("restart"));
+    QTRY_COMPARE(triggeredSpy.count(), 1);
+    m_daemon->release(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("restart"));
+}
+
+void KGlobalAccelClientTest::testRemove()
+{
+    QAction *action = createAction(QStringLiteral("remove"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {QKeySequence(Qt::META | Qt::Key_F7)}, KGlobalAccel::NoAutoloading));
+
+    KGlobalAccel::self()->removeAllShortcuts(action);
+    QVERIFY(!KGlobalAccel::self()->hasShortcut(action));
+    QTRY_VERIFY(!m_daemon->isRegistered(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("remove")));
+
+    // Removing an action leaves the shortcuts of the others alone
+    QAction *first = createAction(QStringLiteral("removeFirst"));
+    QAction *second = createAction(QStringLiteral("removeSecond"));
+    QAction *third = createAction(QStringLiteral("removeThird"));
+    QVERIFY(KGlobalAccel::self()->setGlobalShortcut(first, QKeySequence(Qt::META | Qt::Key_1)));
+    QVERIFY(KGlobalAccel::self()->setGlobalShortcut(second, QKeySequence(Qt::META | Qt::Key_2)));
+    QVERIFY(KGlobalAccel::self()->setDefaultShortcut(third, {QKeySequence(Qt::META | Qt::Key_3)}));
+    KGlobalAccel::self()->removeAllShortcuts(first);
+    QVERIFY(!KGlobalAccel::self()->hasShortcut(first));
+    QCOMPARE(KGlobalAccel::self()->shortcut(second), QList<QKeySequence>{QKeySequence(Qt::META | Qt::Key_2)});
+    QCOMPARE(KGlobalAccel::self()->defaultShortcut(second), QList<QKeySequence>{QKeySequence(Qt::META | Qt::Key_2)});
+    QVERIFY(KGlobalAccel::self()->hasShortcut(third));
+    QVERIFY(KGlobalAccel::self()->shortcut(third).isEmpty());
+    QCOMPARE(KGlobalAccel::self()->defaultShortcut(third), QList<QKeySequence>{QKeySequence(Qt::META | Qt::Key_3)});
+    KGlobalAccel::self()->removeAllShortcuts(second);
+    KGlobalAccel::self()->removeAllShortcuts(third);
+
+    // An action that moved to another component is removed under its new name
+    const QString otherComponent = QStringLiteral("kglobalaccelclienttest-moved");
+    QAction *moved = createAction(QStringLiteral("removeMoved"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(moved, {QKeySequence(Qt::META | Qt::Key_4)}, KGlobalAccel::NoAutoloading));
+    moved->setProperty("componentName", otherComponent);
+    const QList<QKeySequence> movedKeys{QKeySequence(Qt::META | Qt::Key_5)};
+    QVERIFY(KGlobalAccel::self()->setShortcut(moved, movedKeys, KGlobalAccel::NoAutoloading));
+    QTRY_VERIFY(m_daemon->isRegistered(otherComponent, QStringLiteral("removeMoved")));
+    QVERIFY(KGlobalAccel::self()->hasShortcut(moved));
+    QCOMPARE(KGlobalAccel::self()->shortcut(moved), movedKeys);
+    // kglobalaccel already has these keys under the new name
+    m_daemon->resetCallCounts();
+    QVERIFY(KGlobalAccel::self()->setShortcut(moved, movedKeys, KGlobalAccel::NoAutoloading));
+    QTest::qWait(50);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("setShortcutKeys")), 0);
+    KGlobalAccel::self()->removeAllShortcuts(moved);
+    QVERIFY(!KGlobalAccel::self()->hasShortcut(moved));
+    QTRY_VERIFY(!m_daemon->isRegistered(otherComponent, QStringLiteral("removeMoved")));
+
+    // Destroyed actions are marked inactive
+    QAction *destroyed = createAction(QStringLiteral("destroyed"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(destroyed, {QKeySequence(Qt::META | Qt::Key_F8)}, KGlobalAccel::NoAutoloading));
+    delete destroyed;
+    QTRY_VERIFY(!m_daemon->isPresent(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("destroyed")));
+    QVERIFY(m_daemon->isRegistered(QStringLiteral("kglobalaccelclienttest"), QStringLiteral("destroyed")));
+}
+
+void KGlobalAccelClientTest::testSharedNames()
+{
+    // Actions with the same names are the same shortcut as far as kglobalaccel is concerned
+    const QString component = QStringLiteral("kglobalaccelclienttest");
+    const QString name = QStringLiteral("shared");
+    const QList<QKeySequence> keys{QKeySequence(Qt::META | Qt::Key_F9)};
+    QAction *first = createAction(name);
+    QAction *second = createAction(name);
+    QVERIFY(KGlobalAccel::self()->setShortcut(first, keys, KGlobalAccel::NoAutoloading));
+    QVERIFY(KGlobalAccel::self()->setShortcut(second, keys, KGlobalAccel::NoAutoloading));
+
+    QSignalSpy firstSpy(first, &QAction::triggered);
+    QSignalSpy secondSpy(second, &QAction::triggered);
+
+    // The action registered first gets it
+    m_daemon->press(component, name);
+    QTRY_COMPARE(firstSpy.count(), 1);
+    QCOMPARE(secondSpy.count(), 0);
+    m_daemon->release(component, name);
+
+    // and hands it over once it is gone
+    delete first;
+    m_daemon->press(component, name);
+    QTRY_COMPARE(secondSpy.count(), 1);
+    m_daemon->release(component, name);
+
+    // The action is still tracked after it moved to another component
+    const QString otherComponent = QStringLiteral("kglobalaccelclienttest-shared");
+    second->setProperty("componentName", otherComponent);
+    QVERIFY(KGlobalAccel::self()->setShortcut(second, keys, KGlobalAccel::NoAutoloading));
+    m_daemon->press(otherComponent, name);
+    QTRY_COMPARE(secondSpy.count(), 2);
+    m_daemon->release(otherComponent, name);
+
+    second->setEnabled(false);
+    m_daemon->press(otherComponent, name);
+    m_daemon->release(otherComponent, name);
+    QTest::qWait(50);
+    QCOMPARE(secondSpy.count(), 2);
+
+    KGlobalAccel::self()->removeAllShortcuts(second);
+}
+
+void KGlobalAccelClientTest::testFriendlyNameChanges()
+{
+    const QString component = QStringLiteral("kglobalaccelclienttest");
+    QAction *action = createAction(QStringLiteral("friendly"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {QKeySequence(Qt::META | Qt::ALT | Qt::Key_F9)}, KGlobalAccel::NoAutoloading));
+    QCOMPARE(m_daemon->friendlyName(component, QStringLiteral("friendly")), QStringLiteral("friendly"));
+    m_daemon->resetCallCounts();
+
+    // A burst of text changes is pushed once
+    action->setText(QStringLiteral("Friendly &One"));
+    action->setText(QStringLiteral("Friendly &Two"));
+    QTRY_COMPARE(m_daemon->friendlyName(component, QStringLiteral("friendly")), QStringLiteral("Friendly Two"));
+    QCOMPARE(m_daemon->callCount(QStringLiteral("doRegister")), 1);
+
+    // Changes that don't affect the id are not pushed at all
+    action->setCheckable(true);
+    action->setToolTip(QStringLiteral("Tool tip"));
+    QTest::qWait(50);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("doRegister")), 1);
+
+    // Neither are changes a batch already registered
+    KGlobalAccel::self()->beginBatch();
+    action->setText(QStringLiteral("Friendly Three"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {QKeySequence(Qt::META | Qt::ALT | Qt::Key_F10)}, KGlobalAccel::NoAutoloading));
+    KGlobalAccel::self()->commitBatch();
+    QCOMPARE(m_daemon->friendlyName(component, QStringLiteral("friendly")), QStringLiteral("Friendly Three"));
+    QTest::qWait(50);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("doRegister")), 1);
+
+    // The component's display name is a dynamic property
+    action->setProperty("componentDisplayName", QStringLiteral("Client Test"));
+    QTRY_COMPARE(m_daemon->componentFriendlyName(component), QStringLiteral("Client Test"));
+    QCOMPARE(m_daemon->callCount(QStringLiteral("doRegister")), 2);
+
+    KGlobalAccel::self()->removeAllShortcuts(action);
+}
+
+void KGlobalAccelClientTest::testRedundantUpdates()
+{
+    const QString component = QStringLiteral("kglobalaccelclienttest");
+    const QList<QKeySequence> keys{QKeySequence(Qt::META | Qt::CTRL | Qt::Key_F1)};
+    QAction *action = createAction(QStringLiteral("redundant"));
+    QVERIFY(KGlobalAccel::setGlobalShortcut(action, keys));
+    m_daemon->resetCallCounts();
+
+    // Setting the keys the action already has doesn't bother the daemon
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, keys, KGlobalAccel::NoAutoloading));
+    QVERIFY(KGlobalAccel::self()->setDefaultShortcut(action, keys, KGlobalAccel::NoAutoloading));
+    QVERIFY(KGlobalAccel::setGlobalShortcut(action, keys));
+    QCOMPARE(m_daemon->callCount(QStringLiteral("setShortcutKeys")), 0);
+
+    // With asynchronous updates a burst of changes is sent once
+    KGlobalAccel::self()->setAsynchronousUpdates(true);
+    const QList<QKeySequence> finalKeys{QKeySequence(Qt::META | Qt::CTRL | Qt::Key_F3)};
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {QKeySequence(Qt::META | Qt::CTRL | Qt::Key_F2)}, KGlobalAccel::NoAutoloading));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, finalKeys, KGlobalAccel::NoAutoloading));
+    QCOMPARE(KGlobalAccel::self()->shortcut(action), finalKeys);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("setShortcutKeysBatch")), 0);
+    QTRY_COMPARE(m_daemon->keys(component, QStringLiteral("redundant")), finalKeys);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("setShortcutKeysBatch")), 1);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("setShortcutKeys")), 0);
+
+    // Switching them off sends what is still queued
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, keys, KGlobalAccel::NoAutoloading));
+    KGlobalAccel::self()->setAsynchronousUpdates(false);
+    QCOMPARE(m_daemon->keys(component, QStringLiteral("redundant")), keys);
+
+    KGlobalAccel::self()->removeAllShortcuts(action);
+}
+
+void KGlobalAccelClientTest::testMultiChordInfos()
+{
+    QAction *action = createAction(QStringLiteral("multiChord"));
+    const QKeySequence key(Qt::META | Qt::Key_K, Qt::META | Qt::Key_L, Qt::Key_M);
+    const QKeySequence defaultKey(Qt::META | Qt::Key_K, Qt::META | Qt::Key_N);
+    QVERIFY(KGlobalAccel::self()->setDefaultShortcut(action, {defaultKey}, KGlobalAccel::NoAutoloading));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {key}, KGlobalAccel::NoAutoloading));
+
+    // All keys of a sequence arrive, not just the first one
+    const QList<KGlobalShortcutInfo> infos = KGlobalAccel::globalShortcutsByKey(key);
+    QCOMPARE(infos.size(), 1);
+    QCOMPARE(infos.at(0).keys(), QList<QKeySequence>{key});
+    QCOMPARE(infos.at(0).defaultKeys(), QList<QKeySequence>{defaultKey});
+
+    KGlobalAccel::self()->removeAllShortcuts(action);
+}
+
+void KGlobalAccelClientTest::testInfoTableFallback()
+{
+    QAction *action = createAction(QStringLiteral("tableFallback"));
+    const QKeySequence key(Qt::META | Qt::CTRL | Qt::Key_F5);
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {key}, KGlobalAccel::NoAutoloading));
+
+    // A kglobalacceld without the table methods is asked once, then the old methods are used
+    m_daemon->setInfoTablesSupported(false);
+    m_daemon->resetCallCounts();
+    QFuture<QList<KGlobalShortcutInfo>> infos = KGlobalAccel::globalShortcutsByKeyAsync(key);
+    QTRY_VERIFY(infos.isFinished());
+    QCOMPARE(infos.result().size(), 1);
+    QCOMPARE(infos.result().constFirst().uniqueName(), QStringLiteral("tableFallback"));
+    QCOMPARE(infos.result().constFirst().keys(), QList<QKeySequence>{key});
+    QCOMPARE(m_daemon->callCount(QStringLiteral("globalShortcutsByKeyTable")), 1);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("globalShortcutsByKey")), 1);
+
+    QCOMPARE(KGlobalAccel::globalShortcutsByKey(key).size(), 1);
+    KGlobalShortcutInfoStream stream;
+    stream.setComponent(QStringLiteral("kglobalaccelclienttest"));
+    QSignalSpy finishedSpy(&stream, &KGlobalShortcutInfoStream::finished);
+    stream.start();
+    QVERIFY(finishedSpy.wait());
+    QVERIFY(stream.errorString().isEmpty());
+    QCOMPARE(m_daemon->callCount(QStringLiteral("globalShortcutsByKeyTable")), 1);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("globalShortcutsByKey")), 2);
+    QCOMPARE(m_daemon->callCount(QStringLiteral("shortcutInfoTable")), 0);
+    QVERIFY(m_daemon->callCount(QStringLiteral("shortcutInfos")) > 0);
+
+    m_daemon->setInfoTablesSupported(true);
+    KGlobalAccel::self()->removeAllShortcuts(action);
+}
+
+void KGlobalAccelClientTest::testPrivateConnection()
+{
+    const QString component = QStringLiteral("kglobalaccelclienttest");
+    QAction *action = createAction(QStringLiteral("private"));
+    QVERIFY(KGlobalAccel::self()->setShortcut(action, {QKeySequence(Qt::META | Qt::CTRL | Qt::Key_F8)}, KGlobalAccel::NoAutoloading));
+
+    KGlobalAccel::self()->setPrivateConnection(true);
+    QVERIFY(KGlobalAccel::self()->privateConnection());
+
+    // Signals are received in the worker thread, which hands them to ours without our event loop
+    // reading the bus or delivering them to anything else
+    QThread *triggeredIn = nullptr;
+    connect(action, &QAction::triggered, this, [&triggeredIn] {
+        triggeredIn = QThread::currentThread();
+    });
+    m_daemon->press(component, QStringLiteral("private"));
+    QDeadlineTimer deadline(5000);
+    while (!triggeredIn && !deadline.hasExpired()) {
+        QThread::msleep(10);
+        QCoreApplication::sendPostedEvents(KGlobalAccel::self(), QEvent::MetaCall);
+    }
+    QVERIFY(triggeredIn);
+    QCOMPARE(triggeredIn, thread());
+    m_daemon->release(component, QStringLiteral("private"));
+
+    QSignalSpy changedSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutChanged);
+    const QList<QKeySequence> newKeys{QKeySequence(Qt::META | Qt::CTRL | Qt::SHIFT | Qt::Key_F8)};
+    m_daemon->changeKeys(component, QStringLiteral("private"), newKeys);
+    QTRY_COMPARE(changedSpy.count(), 1);
+    QCOMPARE(KGlobalAccel::self()->shortcut(action), newKeys);
+
+    // Switching back keeps the shortcuts working
+    KGlobalAccel::self()->setPrivateConnection(false);
+    triggeredIn = nullptr;
+    m_daemon->press(component, QStringLiteral("private"));
+    m_daemon->release(component, QStringLiteral("private"));
+    QTRY_VERIFY(triggeredIn);
+
+    // Outside of kglobalacceld the private connection goes to the session bus
+    QDBusConnection::disconnectFromBus(QStringLiteral("kglobalacceld"));
+    KGlobalAccel::self()->setPrivateConnection(true);
+    const QDBusConnection privateConnection(QStringLiteral("kglobalaccel-private"));
+    QVERIFY(privateConnection.isConnected());
+    triggeredIn = nullptr;
+    m_daemon->press(component, QStringLiteral("private"));
+    m_daemon->release(component, QStringLiteral("private"));
+    QTRY_VERIFY(triggeredIn);
+    QCOMPARE(triggeredIn, thread());
+
+    QVERIFY(QDBusConnection::connectToBus(m_daemon->busAddress(), QStringLiteral("kglobalacceld")).isConnected());
+    KGlobalAccel::self()->setPrivateConnection(false);
+    QVERIFY(!QDBusConnection(QStringLiteral("kglobalaccel-private")).isConnected());
+
+    KGlobalAccel::self()->removeAllShortcuts(action);
+}
+
+// The private bus is the session bus of the test, it doesn't touch the one of the desktop
+static void useFakeSessionBus()
+{
+    FakeKGlobalAccelDaemon::useAsSessionBus();
+}
+Q_CONSTRUCTOR_FUNCTION(useFakeSessionBus)
+
+QTEST_MAIN(KGlobalAccelClientTest)
+
+#include "kglobalaccelclienttest.moc"
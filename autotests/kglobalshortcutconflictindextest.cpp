@@ -0,0 +1,146 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "sequencehelpers_p.h"
+
+#include <KGlobalShortcutConflictIndex>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QTest>
+
+class KGlobalShortcutConflictIndexTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testFind_data();
+    void testFind();
+    void testShiftTab();
+    void testInsertAndRemove();
+    void testMatchesMatchSequences();
+};
+
+static QStringList sorted(QStringList list)
+{
+    list.sort();
+    return list;
+}
+
+void KGlobalShortcutConflictIndexTest::testFind_data()
+{
+    QTest::addColumn<QKeySequence>("query");
+    QTest::addColumn<QStringList>("equal");
+    QTest::addColumn<QStringList>("shadows");
+    QTest::addColumn<QStringList>("shadowed");
+
+    // The examples from KGlobalAccel::MatchType, with (Alt+B, Alt+F, Alt+G) assigned to "bfg"
+    QTest::newRow("exact") << QKeySequence(Qt::ALT | Qt::Key_B, Qt::ALT | Qt::Key_F, Qt::ALT | Qt::Key_G) << QStringList{QStringLiteral("bfg")}
+                           << QStringList() << QStringList{QStringLiteral("f")};
+    QTest::newRow("shadows from the start") << QKeySequence(Qt::ALT | Qt::Key_B, Qt::ALT | Qt::Key_F) << QStringList() << QStringList{QStringLiteral("bfg")}
+                                            << QStringList{QStringLiteral("f")};
+    QTest::newRow("shadows at the end") << QKeySequence(Qt::ALT | Qt::Key_F, Qt::ALT | Qt::Key_G) << QStringList() << QStringList{QStringLiteral("bfg")}
+                                        << QStringList{QStringLiteral("f")};
+    QTest::newRow("shadowed at the end") << QKeySequence(Qt::ALT | Qt::Key_B, Qt::ALT | Qt::Key_F, Qt::ALT | Qt::Key_G, Qt::Key_A) << QStringList()
+                                         << QStringList() << QStringList{QStringLiteral("bfg"), QStringLiteral("f")};
+    QTest::newRow("shadowed from the start") << QKeySequence(Qt::Key_A, Qt::ALT | Qt::Key_B, Qt::ALT | Qt::Key_F, Qt::ALT | Qt::Key_G) << QStringList()
+                                             << QStringList() << QStringList{QStringLiteral("bfg"), QStringLiteral("f")};
+    QTest::newRow("single key") << QKeySequence(Qt::ALT | Qt::Key_F) << QStringList{QStringLiteral("f")} << QStringList{QStringLiteral("bfg")} << QStringList();
+    QTest::newRow("unrelated") << QKeySequence(Qt::ALT | Qt::Key_G, Qt::ALT | Qt::Key_B) << QStringList() << QStringList() << QStringList();
+    QTest::newRow("empty") << QKeySequence() << QStringList() << QStringList() << QStringList();
+}
+
+void KGlobalShortcutConflictIndexTest::testFind()
+{
+    QFETCH(QKeySequence, query);
+    QFETCH(QStringList, equal);
+    QFETCH(QStringList, shadows);
+    QFETCH(QStringList, shadowed);
+
+    KGlobalShortcutConflictIndex index;
+    index.insert(QStringLiteral("bfg"), {QKeySequence(Qt::ALT | Qt::Key_B, Qt::ALT | Qt::Key_F, Qt::ALT | Qt::Key_G)});
+    index.insert(QStringLiteral("f"), {QKeySequence(Qt::META | Qt::Key_F), QKeySequence(Qt::ALT | Qt::Key_F)});
+
+    QCOMPARE(sorted(index.find(query, KGlobalAccel::Equal)), equal);
+    QCOMPARE(sorted(index.find(query, KGlobalAccel::Shadows)), shadows);
+    QCOMPARE(sorted(index.find(query, KGlobalAccel::Shadowed)), shadowed);
+}
+
+void KGlobalShortcutConflictIndexTest::testShiftTab()
+{
+    KGlobalShortcutConflictIndex index;
+    index.insert(QStringLiteral("backtab"), {QKeySequence(Qt::SHIFT | Qt::Key_Backtab)});
+
+    QCOMPARE(index.find(QKeySequence(Qt::SHIFT | Qt::Key_Tab)), QStringList{QStringLiteral("backtab")});
+}
+
+void KGlobalShortcutConflictIndexTest::testInsertAndRemove()
+{
+    KGlobalShortcutConflictIndex index;
+    QVERIFY(index.isEmpty());
+
+    const QKeySequence first(Qt::META | Qt::Key_A, Qt::META | Qt::Key_A);
+    const QKeySequence second(Qt::META | Qt::Key_B);
+    index.insert(QStringLiteral("action"), {first, QKeySequence()});
+    QCOMPARE(index.size(), 1);
+    QCOMPARE(index.keys(QStringLiteral("action")), QList<QKeySequence>{first});
+    QCOMPARE(index.find(QKeySequence(Qt::META | Qt::Key_A), KGlobalAccel::Shadows), QStringList{QStringLiteral("action")});
+
+    // Inserting again replaces the keys
+    index.insert(QStringLiteral("action"), {second});
+    QCOMPARE(index.size(), 1);
+    QVERIFY(index.find(first).isEmpty());
+    QVERIFY(index.find(QKeySequence(Qt::META | Qt::Key_A), KGlobalAccel::Shadows).isEmpty());
+    QCOMPARE(index.find(second), QStringList{QStringLiteral("action")});
+
+    index.remove(QStringLiteral("action"));
+    QVERIFY(index.isEmpty());
+    QVERIFY(!index.contains(QStringLiteral("action")));
+    QVERIFY(index.find(second).isEmpty());
+
+    index.insert(QStringLiteral("action"), {first});
+    index.clear();
+    QVERIFY(index.isEmpty());
+    QVERIFY(index.find(first).isEmpty());
+}
+
+void KGlobalShortcutConflictIndexTest::testMatchesMatchSequences()
+{
+    // Few distinct keys, so that many sequences overlap
+    const int keys[] = {(Qt::META | Qt::Key_A).toCombined(), (Qt::META | Qt::Key_B).toCombined(), Qt::Key_C};
+    QRandomGenerator random(42);
+    const auto randomSequence = [&] {
+        int k[4] = {0, 0, 0, 0};
+        const int length = random.bounded(1, 5);
+        for (int i = 0; i < length; ++i) {
+            k[i] = keys[random.bounded(3)];
+        }
+        return QKeySequence(k[0], k[1], k[2], k[3]);
+    };
+
+    KGlobalShortcutConflictIndex index;
+    QHash<QString, QList<QKeySequence>> shortcuts;
+    for (int i = 0; i < 200; ++i) {
+        const QString id = QString::number(i);
+        const QList<QKeySequence> sequences{randomSequence(), randomSequence()};
+        shortcuts.insert(id, sequences);
+        index.insert(id, sequences);
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        const QKeySequence query = randomSequence();
+        QStringList expected;
+        for (auto it = shortcuts.cbegin(); it != shortcuts.cend(); ++it) {
+            if (Utils::matchSequences(query, it.value())) {
+                expected.append(it.key());
+            }
+        }
+        QCOMPARE(sorted(index.conflicts(query)), sorted(expected));
+    }
+}
+
+QTEST_MAIN(KGlobalShortcutConflictIndexTest)
+
+#include "kglobalshortcutconflictindextest.moc"
@@ -0,0 +1,213 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef IPCCOUNTERS_P_H
+#define IPCCOUNTERS_P_H
+
+#include "kglobalaccel.h"
+
+#include <QKeySequence>
+#include <QList>
+#include <QString>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+/**
+ * @internal
+ *
+ * What KGlobalAccel sent to kglobalaccel, see KGlobalAccelIpcStats. The byte counts estimate the
+ * size of the marshalled arguments, ignoring alignment and the message header, QtDBus doesn't
+ * tell us the real size. Walking the arguments isn't free, so bytes are only counted while a
+ * stats object exists.
+ */
+class IpcCounters
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// The D-Bus methods we call, of kglobalaccel, its components and the bus itself
+    enum Method {
+        AllComponents,
+        AllShortcutInfos,
+        CleanUp,
+        DoRegister,
+        GetComponent,
+        GetShortcutContexts,
+        GlobalShortcutAvailable,
+        GlobalShortcutsByKey,
+        GlobalShortcutsByKeyTable,
+        IsActive,
+        NameHasOwner,
+        SetForeignShortcutKeys,
+        SetInactive,
+        SetInverseShortcutActions,
+        SetShortcutKeys,
+        SetShortcutKeysBatch,
+        ShortcutInfoTable,
+        ShortcutInfos,
+        ShortcutKeys,
+        StartServiceByName,
+        Unregister,
+        MethodCount,
+    };
+    /// The D-Bus names of the methods, in the order of Method
+    static constexpr std::array<QLatin1String, MethodCount> MethodNames{QLatin1String("allComponents"),
+                                                                        QLatin1String("allShortcutInfos"),
+                                                                        QLatin1String("cleanUp"),
+                                                                        QLatin1String("doRegister"),
+                                                                        QLatin1String("getComponent"),
+                                                                        QLatin1String("getShortcutContexts"),
+                                                                        QLatin1String("globalShortcutAvailable"),
+                                                                        QLatin1String("globalShortcutsByKey"),
+                                                                        QLatin1String("globalShortcutsByKeyTable"),
+                                                                        QLatin1String("isActive"),
+                                                                        QLatin1String("NameHasOwner"),
+                                                                        QLatin1String("setForeignShortcutKeys"),
+                                                                        QLatin1String("setInactive"),
+                                                                        QLatin1String("setInverseShortcutActions"),
+                                                                        QLatin1String("setShortcutKeys"),
+                                                                        QLatin1String("setShortcutKeysBatch"),
+                                                                        QLatin1String("shortcutInfoTable"),
+                                                                        QLatin1String("shortcutInfos"),
+                                                                        QLatin1String("shortcutKeys"),
+                                                                        QLatin1String("StartServiceByName"),
+                                                                        QLatin1String("unregister")};
+
+    struct MethodCounters {
+        int calls = 0;
+        qint64 bytes = 0;
+        Clock::duration blocked{0};
+    };
+
+    /// Adds the time between construction and destruction to the blocked time of a method
+    class BlockingScope
+    {
+    public:
+        BlockingScope(IpcCounters *counters, Method method)
+            : m_counters(counters)
+            , m_method(method)
+            , m_start(Clock::now())
+        {
+        }
+        ~BlockingScope()
+        {
+            m_counters->m_methods[m_method].blocked += Clock::now() - m_start;
+        }
+        Q_DISABLE_COPY_MOVE(BlockingScope)
+
+    private:
+        IpcCounters *const m_counters;
+        const Method m_method;
+        const Clock::time_point m_start;
+    };
+
+    /// While there are users the bytes sent are counted too
+    void addUser()
+    {
+        ++m_users;
+    }
+    void removeUser()
+    {
+        --m_users;
+    }
+
+    template<typename... Args>
+    void countCall(Method method, const Args &...arguments)
+    {
+        MethodCounters &counters = m_methods[method];
+        ++counters.calls;
+        if (m_users > 0) {
+            counters.bytes += (qint64(0) + ... + wireSize(arguments));
+        }
+    }
+
+    /// Measure the time blocked in a call of @p method until the returned scope is left
+    [[nodiscard]] BlockingScope blocking(Method method)
+    {
+        return BlockingScope(this, method);
+    }
+
+    void countSignal()
+    {
+        ++m_signalsReceived;
+    }
+    void countRestart()
+    {
+        ++m_restartsHandled;
+    }
+
+    void reset()
+    {
+        m_methods.fill(MethodCounters());
+        m_signalsReceived = 0;
+        m_restartsHandled = 0;
+    }
+
+    const MethodCounters &counters(Method method) const
+    {
+        return m_methods[method];
+    }
+    /// The counters of the method with the D-Bus name @p name, zero for unknown methods
+    MethodCounters counters(const QString &name) const
+    {
+        const auto it = std::find(MethodNames.cbegin(), MethodNames.cend(), name);
+        return it == MethodNames.cend() ? MethodCounters() : m_methods[it - MethodNames.cbegin()];
+    }
+    int signalsReceived() const
+    {
+        return m_signalsReceived;
+    }
+    int restartsHandled() const
+    {
+        return m_restartsHandled;
+    }
+
+private:
+    static qint64 wireSize(bool)
+    {
+        return 4;
+    }
+    static qint64 wireSize(int)
+    {
+        return 4;
+    }
+    static qint64 wireSize(uint)
+    {
+        return 4;
+    }
+    static qint64 wireSize(KGlobalAccel::MatchType)
+    {
+        return 4;
+    }
+    static qint64 wireSize(const QString &string)
+    {
+        // Length, the mostly ASCII characters and the terminating null
+        return 4 + string.size() + 1;
+    }
+    static qint64 wireSize(const QKeySequence &)
+    {
+        // Always sent as four ints
+        return 4 + 4 * 4;
+    }
+    template<typename T>
+    static qint64 wireSize(const QList<T> &list)
+    {
+        qint64 size = 4;
+        for (const T &element : list) {
+            size += wireSize(element);
+        }
+        return size;
+    }
+
+    std::array<MethodCounters, MethodCount> m_methods;
+    int m_users = 0;
+    int m_signalsReceived = 0;
+    int m_restartsHandled = 0;
+};
+
+#endif
@@ -12,94 +12,156 @@
 #include "kglobalaccel_debug.h"
 #include "kglobalaccel_p.h"
 
+#include <chrono>
 #include <memory>
+#include <optional>
+#include <utility>
 
 #include <QAction>
 #include <QDBusMessage>
 #include <QDBusMetaType>
+#include <QDBusPendingCallWatcher>
 #include <QGuiApplication>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QTimer>
 #include <config-kglobalaccel.h>
 
 #if WITH_X11
 #include <private/qtx11extras_p.h>
 #endif
 
-org::kde::kglobalaccel::Component *KGlobalAccelPrivate::getComponent(const QString &componentUnique, bool remember = false)
+namespace
 {
-    // Check if we already have this component
-    {
-        auto component = components.value(componentUnique);
-        if (component) {
-            return component;
-        }
+QString serviceName()
+{
+    return QStringLiteral("org.kde.kglobalaccel");
+}
+
+// The connection used with KGlobalAccel::setPrivateConnection()
+QString privateConnectionName()
+{
+    return QStringLiteral("kglobalaccel-private");
+}
+
+// Upper bound of the random delay before talking to a restarted kglobalaccel
+constexpr std::chrono::milliseconds s_restoreJitter{200};
+// Delay before the first retry of a failed restore, doubled for each further one
+constexpr std::chrono::milliseconds s_restoreRetryDelay{250};
+constexpr int s_restoreAttempts = 5;
+
+// A random delay of up to s_restoreJitter. KGLOBALACCEL_RESTORE_JITTER overrides the upper bound in
+// milliseconds, tests and benchmarks set it to 0 to restore right away.
+std::chrono::milliseconds restoreJitter()
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue("KGLOBALACCEL_RESTORE_JITTER", &ok);
+    const int bound = ok && value >= 0 ? value : int(s_restoreJitter.count());
+    return std::chrono::milliseconds(bound > 0 ? QRandomGenerator::global()->bounded(bound) : 0);
+}
+
+// How long we keep the path of a component we don't have actions in after its last use
+constexpr std::chrono::minutes s_componentIdleTime{5};
+}
+
+QString KGlobalAccelPrivate::componentPath(const QString &componentUnique)
+{
+    auto it = components.find(componentUnique);
+    if (it != components.end()) {
+        it->lastUsed = std::chrono::steady_clock::now();
+        return it->path;
     }
 
     // Get the path for our component. We have to do that because
     // componentUnique is probably not a valid dbus object path
-    QDBusReply<QDBusObjectPath> reply = iface()->getComponent(componentUnique);
+    prepareBlockingCall();
+    ipcCounters.countCall(IpcCounters::GetComponent, componentUnique);
+    const auto reply = waitForReply<QDBusReply<QDBusObjectPath>>(IpcCounters::GetComponent, iface()->getComponent(componentUnique));
     if (!reply.isValid()) {
-        if (reply.error().name() == QLatin1String("org.kde.kglobalaccel.NoSuchComponent")) {
-            // No problem. The component doesn't exists. That's normal
-            return nullptr;
+        if (reply.error().name() != QLatin1String("org.kde.kglobalaccel.NoSuchComponent")) {
+            // An unknown error. A component that doesn't exist is normal.
+            qCDebug(KGLOBALACCEL_LOG) << "Failed to get dbus path for component " << componentUnique << reply.error();
         }
-
-        // An unknown error.
-        qCDebug(KGLOBALACCEL_LOG) << "Failed to get dbus path for component " << componentUnique << reply.error();
-        return nullptr;
+        return QString();
     }
 
-    // Now get the component
-    org::kde::kglobalaccel::Component *component =
-        new org::kde::kglobalaccel::Component(QStringLiteral("org.kde.kglobalaccel"), reply.value().path(), m_bus, q);
+    rememberComponentPath(componentUnique, reply.value().path());
+    return reply.value().path();
+}
 
-    // No component no cleaning
-    if (!component->isValid()) {
-        qCDebug(KGLOBALACCEL_LOG) << "Failed to get component" << componentUnique << m_bus.lastError();
-        return nullptr;
+void KGlobalAccelPrivate::rememberComponentPath(const QString &componentUnique, const QString &path)
+{
+    ComponentEntry &entry = components[componentUnique];
+    entry.path = path;
+    entry.lastUsed = std::chrono::steady_clock::now();
+
+    if (!m_componentEvictionTimer) {
+        m_componentEvictionTimer = new QTimer(q);
+        m_componentEvictionTimer->setInterval(s_componentIdleTime);
+        QObject::connect(m_componentEvictionTimer, &QTimer::timeout, q, [this] {
+            evictIdleComponents();
+        });
     }
-
-    if (remember) {
-        // Connect to the signals we are interested in.
-        QObject::connect(component,
-                         &org::kde::kglobalaccel::Component::globalShortcutPressed,
-                         q,
-                         [this](const QString &componentUnique, const QString &shortcutUnique, qlonglong timestamp) {
-                             invokeAction(componentUnique, shortcutUnique, timestamp, ShortcutState::Pressed);
-                         });
-
-        QObject::connect(component,
-                         &org::kde::kglobalaccel::Component::globalShortcutRepeated,
-                         q,
-                         [this](const QString &componentUnique, const QString &shortcutUnique, qlonglong timestamp) {
-                             invokeAction(componentUnique, shortcutUnique, timestamp, ShortcutState::Repeated);
-                         });
-
-        QObject::connect(component,
-                         &org::kde::kglobalaccel::Component::globalShortcutReleased,
-                         q,
-                         [this](const QString &componentUnique, const QString &shortcutUnique, qlonglong) {
-                             invokeDeactivate(componentUnique, shortcutUnique);
-                         });
-
-        components[componentUnique] = component;
+    if (!m_componentEvictionTimer->isActive()) {
+        m_componentEvictionTimer->start();
     }
-
-    return component;
 }
 
-namespace
-{
-QString serviceName()
+void KGlobalAccelPrivate::evictIdleComponents()
 {
-    return QStringLiteral("org.kde.kglobalaccel");
+    const auto idleSince = std::chrono::steady_clock::now() - s_componentIdleTime;
+    bool idleLeft = false;
+    components.removeIf([this, idleSince, &idleLeft](const auto &it) {
+        // Components we have actions in are used again on each update
+        if (componentActionCounts.contains(it.key())) {
+            return false;
+        }
+        if (it.value().lastUsed > idleSince) {
+            idleLeft = true;
+            return false;
+        }
+        return true;
+    });
+    if (!idleLeft) {
+        m_componentEvictionTimer->stop();
+    }
 }
+
+bool KGlobalAccelPrivate::callComponent(const QString &componentUnique, IpcCounters::Method method)
+{
+    const QString path = componentPath(componentUnique);
+    if (path.isEmpty()) {
+        return false;
+    }
+
+    const auto message =
+        QDBusMessage::createMethodCall(serviceName(), path, org::kde::kglobalaccel::Component::staticInterfaceName(), IpcCounters::MethodNames[method]);
+    prepareBlockingCall();
+    ipcCounters.countCall(method);
+    const auto reply = waitForReply<QDBusReply<bool>>(method, m_bus.asyncCall(message));
+    if (!reply.isValid()) {
+        qCDebug(KGLOBALACCEL_LOG) << "Failed to call" << IpcCounters::MethodNames[method] << "of component" << componentUnique << reply.error();
+        // The component may be gone, ask for its path again next time
+        components.remove(componentUnique);
+        return false;
+    }
+    return reply.value();
 }
 
 void KGlobalAccelPrivate::cleanup()
 {
-    qDeleteAll(components);
+    components.clear();
+    if (m_workerThread) {
+        // The dispatcher may only go once its thread doesn't deliver signals to it anymore
+        m_workerThread->quit();
+        m_workerThread->wait();
+    }
+    delete m_dispatcher;
+    m_dispatcher = nullptr;
+    delete m_workerThread;
+    m_workerThread = nullptr;
     delete m_iface;
     m_iface = nullptr;
     delete m_watcher;
@@ -115,77 +177,356 @@ KGlobalAccelPrivate::KGlobalAccelPrivate(KGlobalAccel *qq)
         m_bus = kglobalaccelInternalBus;
     }
 
-    m_watcher = new QDBusServiceWatcher(serviceName(), m_bus, QDBusServiceWatcher::WatchForOwnerChange, q);
-    QObject::connect(m_watcher,
-                     &QDBusServiceWatcher::serviceOwnerChanged,
-                     q,
-                     [this](const QString &serviceName, const QString &oldOwner, const QString &newOwner) {
-                         serviceOwnerChanged(serviceName, oldOwner, newOwner);
-                     });
+    // Nothing talks to the bus before iface() is used, applications that never register a
+    // shortcut don't pay for kglobalaccel at all
+
+    // Action ids are cached, these are the things they are built from besides the actions themselves
+    m_actionObserver = new KGlobalAccelActionObserver(this, q);
+    m_actionIdTimer = new QTimer(q);
+    m_actionIdTimer->setSingleShot(true);
+    m_actionIdTimer->setInterval(0);
+    QObject::connect(m_actionIdTimer, &QTimer::timeout, q, [this] {
+        pushChangedFriendlyNames();
+    });
+    if (QCoreApplication::instance()) {
+        QObject::connect(QCoreApplication::instance(), &QCoreApplication::applicationNameChanged, q, [this] {
+            invalidateActionId(nullptr);
+        });
+    }
+    if (auto app = qobject_cast<QGuiApplication *>(QCoreApplication::instance())) {
+        QObject::connect(app, &QGuiApplication::applicationDisplayNameChanged, q, [this] {
+            invalidateActionId(nullptr);
+        });
+    }
 }
 
 org::kde::KGlobalAccel *KGlobalAccelPrivate::iface()
 {
     if (!m_iface) {
         m_iface = new org::kde::KGlobalAccel(serviceName(), QStringLiteral("/kglobalaccel"), m_bus);
-        // Make sure kglobalaccel is running. The iface declaration above somehow works anyway.
-        QDBusConnectionInterface *busInterface = m_bus.interface();
-        if (busInterface && !busInterface->isServiceRegistered(serviceName())) {
-            QDBusReply<void> reply = busInterface->startService(serviceName());
-            if (!reply.isValid()) {
-                qCritical() << "Couldn't start kglobalaccel from org.kde.kglobalaccel.service:" << reply.error();
-            }
-        }
 
-        QObject::connect(m_iface, &org::kde::KGlobalAccel::yourShortcutsChanged, q, [this](const QStringList &actionId, const QList<QKeySequence> &newKeys) {
-            shortcutsChanged(actionId, newKeys);
-        });
+        m_watcher = new QDBusServiceWatcher(serviceName(), m_bus, QDBusServiceWatcher::WatchForOwnerChange, q);
+        QObject::connect(m_watcher,
+                         &QDBusServiceWatcher::serviceOwnerChanged,
+                         q,
+                         [this](const QString &serviceName, const QString &oldOwner, const QString &newOwner) {
+                             serviceOwnerChanged(serviceName, oldOwner, newOwner);
+                         });
+        activateService();
+
+        m_dispatcher = new KGlobalAccelDispatcher(this);
+        if (privateConnection) {
+            // Signals are demarshalled in the worker thread, the dispatcher hands them over to us
+            m_workerThread = new QThread;
+            m_workerThread->setObjectName(QStringLiteral("KGlobalAccel D-Bus"));
+            m_dispatcher->moveToThread(m_workerThread);
+            m_workerThread->start();
+        }
+        // One match rule for the shortcut signals of all components, whichever exist now or later
+        bool connected = m_bus.connect(serviceName(),
+                                       QString(),
+                                       org::kde::kglobalaccel::Component::staticInterfaceName(),
+                                       QString(),
+                                       m_dispatcher,
+                                       SLOT(componentSignal(QString, QString, qlonglong, QDBusMessage)));
+        connected = connected
+            && m_bus.connect(serviceName(),
+                             m_iface->path(),
+                             m_iface->interface(),
+                             QStringLiteral("yourShortcutsChanged"),
+                             m_dispatcher,
+                             SLOT(yourShortcutsChanged(QStringList, QList<QKeySequence>)));
+        if (!connected) {
+            qCWarning(KGLOBALACCEL_LOG) << "Failed to connect to the shortcut signals of kglobalaccel" << m_bus.lastError();
+        }
     }
     return m_iface;
 }
 
+void KGlobalAccelPrivate::activateService()
+{
+    QDBusConnectionInterface *busInterface = m_bus.interface();
+    if (!busInterface) {
+        serviceState = ServiceActive;
+        return;
+    }
+    // The bus answers this right away, unlike starting kglobalaccel. If it is running already,
+    // which it is for most applications, registrations and updates go out and wait for their
+    // replies as they always did.
+    bool registered = false;
+    {
+        ipcCounters.countCall(IpcCounters::NameHasOwner, serviceName());
+        const auto blocked = ipcCounters.blocking(IpcCounters::NameHasOwner);
+        registered = busInterface->isServiceRegistered(serviceName());
+    }
+    if (registered) {
+        serviceState = ServiceActive;
+        // Queued while kglobalaccel was being activated through another connection, whose
+        // finishActivation() won't send it anymore
+        if (!pendingRegistrations.isEmpty() || !pendingUpdates.isEmpty()) {
+            scheduleFlush();
+        }
+        return;
+    }
+
+    // Calls to kglobalaccel would start it through D-Bus activation anyway, but nothing would start
+    // it for the shortcut signals we listen to. When many applications start at once, kglobalaccel
+    // may take a while. Registrations and updates are queued until it is there instead of each
+    // application waiting for it in turn, see finishActivation().
+    serviceState = ServiceActivating;
+    ipcCounters.countCall(IpcCounters::StartServiceByName, serviceName(), 0u);
+    auto watcher = new QDBusPendingCallWatcher(busInterface->asyncCall(QStringLiteral("StartServiceByName"), serviceName(), 0u), q);
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished, q, [this](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        const QDBusPendingReply<uint> reply = *watcher;
+        if (reply.isError()) {
+            qCritical() << "Couldn't start kglobalaccel from org.kde.kglobalaccel.service:" << reply.error();
+            // Keep queueing, whoever starts it later gets everything from serviceOwnerChanged().
+            // Should a blocking call send the queue before that, it gets lost and everything is
+            // restored as after a restart.
+            serviceLost = true;
+            return;
+        }
+        finishActivation();
+    });
+}
+
+void KGlobalAccelPrivate::setPrivateConnection(bool enabled)
+{
+    if (enabled == privateConnection) {
+        return;
+    }
+    // kglobalaccel keeps our actions, only our end changes. Whatever is queued for its activation
+    // stays queued until it was activated through the new connection.
+    const bool connected = m_iface;
+    cleanup();
+    serviceState = ServiceInactive;
+    if (m_bus.name() == privateConnectionName()) {
+        QDBusConnection::disconnectFromBus(privateConnectionName());
+    }
+
+    privateConnection = enabled;
+    // Within kglobalacceld its connection is ours alone already
+    m_bus = QDBusConnection(QStringLiteral("kglobalacceld"));
+    if (!m_bus.isConnected()) {
+        m_bus = enabled ? QDBusConnection::connectToBus(QDBusConnection::SessionBus, privateConnectionName()) : QDBusConnection::sessionBus();
+    }
+
+    // Keep receiving the shortcut signals
+    if (connected) {
+        iface();
+    }
+}
+
+void KGlobalAccelPrivate::finishActivation()
+{
+    if (serviceState != ServiceActivating) {
+        return;
+    }
+    serviceState = ServiceActive;
+    qCDebug(KGLOBALACCEL_LOG) << "kglobalaccel is available, sending" << pendingRegistrations.size() << "registrations and" << pendingUpdates.size()
+                              << "updates";
+    // An open batch sends everything once it is committed
+    if (batchDepth == 0) {
+        flushBatch();
+    }
+}
+
+void KGlobalAccelPrivate::flushBeforeExit()
+{
+    if (pendingRegistrations.isEmpty() && pendingUpdates.isEmpty()) {
+        return;
+    }
+    // There is no event loop left to send them later, so send them now and wait for the replies.
+    // If kglobalaccel is still starting, the calls wait for it. This includes an open batch.
+    if (m_flushTimer) {
+        m_flushTimer->stop();
+    }
+    iface();
+    serviceState = ServiceActive;
+    const bool asynchronous = std::exchange(asynchronousUpdates, false);
+    flushBatch();
+    asynchronousUpdates = asynchronous;
+}
+
+void KGlobalAccelPrivate::prepareBlockingCall()
+{
+    iface();
+    finishActivation();
+}
+
+bool KGlobalAccelPrivate::isServiceActive()
+{
+    // Creating the interface starts the activation
+    iface();
+    return serviceState == ServiceActive;
+}
+
+KGlobalAccelDispatcher::KGlobalAccelDispatcher(KGlobalAccelPrivate *d)
+    : d(d)
+{
+}
+
+void KGlobalAccelDispatcher::componentSignal(const QString &componentUnique, const QString &shortcutUnique, qlonglong timestamp, const QDBusMessage &message)
+{
+    const QString member = message.member();
+    // Everything but receiving the signal happens in the thread of KGlobalAccel. Without a
+    // worker thread that is this one and the call is direct.
+    QMetaObject::invokeMethod(
+        d->q,
+        [d = d, componentUnique, shortcutUnique, timestamp, member] {
+            d->ipcCounters.countSignal();
+            if (member == QLatin1String("globalShortcutPressed")) {
+                d->invokeAction(componentUnique, shortcutUnique, timestamp, KGlobalAccelPrivate::Pressed);
+            } else if (member == QLatin1String("globalShortcutRepeated")) {
+                d->invokeAction(componentUnique, shortcutUnique, timestamp, KGlobalAccelPrivate::Repeated);
+            } else if (member == QLatin1String("globalShortcutReleased")) {
+                d->invokeDeactivate(componentUnique, shortcutUnique, timestamp);
+            }
+        },
+        Qt::AutoConnection);
+}
+
+void KGlobalAccelDispatcher::yourShortcutsChanged(const QStringList &actionId, const QList<QKeySequence> &newKeys)
+{
+    QMetaObject::invokeMethod(
+        d->q,
+        [d = d, actionId, newKeys] {
+            d->ipcCounters.countSignal();
+            d->shortcutsChanged(actionId, newKeys);
+        },
+        Qt::AutoConnection);
+}
+
+KGlobalAccelActionObserver::KGlobalAccelActionObserver(KGlobalAccelPrivate *d, QObject *parent)
+    : QObject(parent)
+    , d(d)
+{
+}
+
+bool KGlobalAccelActionObserver::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::DynamicPropertyChange) {
+        const QByteArray name = static_cast<QDynamicPropertyChangeEvent *>(event)->propertyName();
+        if (name == "componentName" || name == "componentDisplayName") {
+            d->invalidateActionId(static_cast<QAction *>(watched));
+        } else if (name == "isConfigurationAction") {
+            // Setting unchanged keys doesn't refresh the dispatch entry anymore
+            auto action = static_cast<QAction *>(watched);
+            if (KGlobalAccelPrivate::DispatchEntry *entry = d->dispatchEntry(action)) {
+                entry->isConfigurationAction = action->property("isConfigurationAction").toBool();
+            }
+        }
+    }
+    return false;
+}
+
 KGlobalAccel::KGlobalAccel()
     : d(new KGlobalAccelPrivate(this))
 {
     qDBusRegisterMetaType<QList<int>>();
     qDBusRegisterMetaType<QKeySequence>();
     qDBusRegisterMetaType<QList<QKeySequence>>();
+    qDBusRegisterMetaType<QList<QList<QKeySequence>>>();
     qDBusRegisterMetaType<QList<QStringList>>();
     qDBusRegisterMetaType<KGlobalShortcutInfo>();
     qDBusRegisterMetaType<QList<KGlobalShortcutInfo>>();
     qDBusRegisterMetaType<KGlobalAccel::MatchType>();
+    KGlobalShortcutInfoTable::registerMetaTypes();
 }
 
 KGlobalAccel::~KGlobalAccel()
 {
+    // Usually done by the post routine already, unless there never was a QCoreApplication
+    d->flushBeforeExit();
     delete d;
 }
 
 // static
 bool KGlobalAccel::cleanComponent(const QString &componentUnique)
 {
-    org::kde::kglobalaccel::Component *component = self()->getComponent(componentUnique);
-    if (!component) {
-        return false;
-    }
-
-    return component->cleanUp();
+    // Cleaning up forgets inactive shortcuts of the component
+    self()->d->shortcutKeysCache.removeIf([&componentUnique](const auto &it) {
+        return it.key().componentUnique == componentUnique;
+    });
+    return self()->d->callComponent(componentUnique, IpcCounters::CleanUp);
 }
 
 // static
 bool KGlobalAccel::isComponentActive(const QString &componentUnique)
 {
-    org::kde::kglobalaccel::Component *component = self()->getComponent(componentUnique);
-    if (!component) {
-        return false;
-    }
+    return self()->d->callComponent(componentUnique, IpcCounters::IsActive);
+}
 
-    return component->isActive();
+// static
+QFuture<bool> KGlobalAccel::cleanComponentAsync(const QString &componentUnique)
+{
+    self()->d->shortcutKeysCache.removeIf([&componentUnique](const auto &it) {
+        return it.key().componentUnique == componentUnique;
+    });
+    return self()->d->callComponentAsync(componentUnique, IpcCounters::CleanUp);
 }
 
-org::kde::kglobalaccel::Component *KGlobalAccel::getComponent(const QString &componentUnique)
+// static
+QFuture<bool> KGlobalAccel::isComponentActiveAsync(const QString &componentUnique)
 {
-    return d->getComponent(componentUnique);
+    return self()->d->callComponentAsync(componentUnique, IpcCounters::IsActive);
+}
+
+QFuture<bool> KGlobalAccelPrivate::callComponentAsync(const QString &componentUnique, IpcCounters::Method method)
+{
+    const auto callMethod = [this, method](const QString &path) {
+        ipcCounters.countCall(method);
+        const auto message =
+            QDBusMessage::createMethodCall(serviceName(), path, org::kde::kglobalaccel::Component::staticInterfaceName(), IpcCounters::MethodNames[method]);
+        return m_bus.asyncCall(message);
+    };
+    const auto toBool = [method](const QDBusPendingCall &call) {
+        const QDBusPendingReply<bool> reply = call;
+        if (reply.isError()) {
+            qCDebug(KGLOBALACCEL_LOG) << "Failed to call" << IpcCounters::MethodNames[method] << reply.error();
+            return false;
+        }
+        return reply.value();
+    };
+
+    // We know the path of the components we are using or asked about recently
+    if (auto it = components.find(componentUnique); it != components.end()) {
+        it->lastUsed = std::chrono::steady_clock::now();
+        return futureForCall<bool>(callMethod(it->path), toBool);
+    }
+
+    auto promise = std::make_shared<QPromise<bool>>();
+    promise->start();
+    ipcCounters.countCall(IpcCounters::GetComponent, componentUnique);
+    auto watcher = new QDBusPendingCallWatcher(iface()->getComponent(componentUnique), q);
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished, q, [this, promise, componentUnique, callMethod, toBool](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        const QDBusPendingReply<QDBusObjectPath> reply = *watcher;
+        if (promise->isCanceled() || reply.isError()) {
+            if (reply.isError() && reply.error().name() != QLatin1String("org.kde.kglobalaccel.NoSuchComponent")) {
+                qCDebug(KGLOBALACCEL_LOG) << "Failed to get dbus path for component" << reply.error();
+            }
+            if (!promise->isCanceled()) {
+                promise->addResult(false);
+            }
+            promise->finish();
+            return;
+        }
+
+        if (!components.contains(componentUnique)) {
+            rememberComponentPath(componentUnique, reply.value().path());
+        }
+        auto callWatcher = new QDBusPendingCallWatcher(callMethod(reply.value().path()), q);
+        QObject::connect(callWatcher, &QDBusPendingCallWatcher::finished, q, [promise, toBool](QDBusPendingCallWatcher *callWatcher) {
+            callWatcher->deleteLater();
+            if (!promise->isCanceled()) {
+                promise->addResult(toBool(*callWatcher));
+            }
+            promise->finish();
+        });
+    });
+    return promise->future();
 }
 
 class KGlobalAccelSingleton
@@ -201,6 +542,7 @@ Q_GLOBAL_STATIC(KGlobalAccelSingleton, s_instance)
 KGlobalAccelSingleton::KGlobalAccelSingleton()
 {
     qAddPostRoutine([]() {
+        s_instance->instance.d->flushBeforeExit();
         s_instance->instance.d->cleanup();
     });
 }
@@ -218,41 +560,109 @@ bool KGlobalAccelPrivate::doRegister(QAction *action)
         return false;
     }
 
-    const bool isRegistered = actions.contains(action);
-    if (isRegistered) {
+    if (isRegistered(action)) {
         return true;
     }
 
-    QStringList actionId = makeActionId(action);
+    const QStringList actionId = makeActionId(action);
+
+    actionIndex.insert(action, actionRecords.size());
+    actionRecords.append(ActionRecord{action, actionId, actionId});
+    actionRecords.last().registration = ++registrationCount;
+    ++componentActionCounts[actionId.at(KGlobalAccel::ComponentUnique)];
+    updateDispatchEntry(action, actionId);
+    if (batchDepth > 0 || asynchronousUpdates || !isServiceActive()) {
+        // Sent together with the shortcut keys in flushBatch()
+        pendingRegistrations.append(action);
+        if (batchDepth == 0) {
+            scheduleFlush();
+        }
+    } else {
+        this->record(action)->sent = true;
+        ipcCounters.countCall(IpcCounters::DoRegister, actionId);
+        iface()->doRegister(actionId);
+    }
 
-    nameToAction.insert(actionId.at(KGlobalAccel::ActionUnique), action);
-    actions.insert(action);
-    iface()->doRegister(actionId);
+    // The friendly names may change at any time, see invalidateActionId()
+    QObject::connect(action, &QAction::changed, q, [this, action] {
+        invalidateActionId(action);
+    });
+    action->installEventFilter(m_actionObserver);
 
     QObject::connect(action, &QObject::destroyed, q, [this, action](QObject *) {
-        if (actions.contains(action) && (actionShortcuts.contains(action) || actionDefaultShortcuts.contains(action))) {
+        const ActionRecord *record = this->record(action);
+        if (record && (record->hasActiveKeys || record->hasDefaultKeys)) {
             remove(action, KGlobalAccelPrivate::SetInactive);
         }
     });
 
+    QObject::connect(action, &QAction::enabledChanged, q, [this, action](bool enabled) {
+        if (DispatchEntry *entry = dispatchEntry(action)) {
+            entry->enabled = enabled;
+        }
+    });
+
     return true;
 }
 
+void KGlobalAccelPrivate::releaseComponent(const QString &componentUnique)
+{
+    // The path of a component without actions may be evicted once it was idle for a while
+    const auto count = componentActionCounts.find(componentUnique);
+    if (count != componentActionCounts.end() && --count.value() <= 0) {
+        componentActionCounts.erase(count);
+        if (auto it = components.find(componentUnique); it != components.end()) {
+            it->lastUsed = std::chrono::steady_clock::now();
+            m_componentEvictionTimer->start();
+        }
+    }
+}
+
+void KGlobalAccelPrivate::markSent(ActionRecord *record, const QStringList &actionId)
+{
+    // The action is counted for the component kglobalaccel knows it under
+    const QString oldComponent = record->sentActionId.at(KGlobalAccel::ComponentUnique);
+    const QString &newComponent = actionId.at(KGlobalAccel::ComponentUnique);
+    if (newComponent != oldComponent) {
+        ++componentActionCounts[newComponent];
+        releaseComponent(oldComponent);
+    }
+    record->sentActionId = actionId;
+    record->sent = true;
+}
+
 void KGlobalAccelPrivate::remove(QAction *action, Removal removal)
 {
     if (!action || action->objectName().isEmpty()) {
         return;
     }
 
-    const bool isRegistered = actions.contains(action);
-    if (!isRegistered) {
+    const ActionRecord *record = this->record(action);
+    if (!record) {
         return;
     }
 
-    QStringList actionId = makeActionId(action);
+    // What kglobalaccel knows the action as
+    const QStringList actionId = record->sentActionId;
+    const bool sent = record->sent;
+    removeDispatchEntry(record);
+    eraseRecord(action);
+
+    releaseComponent(actionId.at(KGlobalAccel::ComponentUnique));
+
+    QObject::disconnect(action, &QAction::enabledChanged, q, nullptr);
+    QObject::disconnect(action, &QAction::changed, q, nullptr);
+    action->removeEventFilter(m_actionObserver);
 
-    nameToAction.remove(actionId.at(KGlobalAccel::ActionUnique), action);
-    actions.remove(action);
+    // Queued by a batch or for asynchronous updates
+    pendingRegistrations.removeAll(action);
+    pendingUpdates.removeIf([action](const PendingUpdate &update) {
+        return update.action == action;
+    });
+    if (!sent) {
+        // kglobalaccel never heard of the action, dropping it from the queues was all there was to do
+        return;
+    }
 
     if (removal == UnRegister) {
         // Complete removal of the shortcut is requested
@@ -275,19 +685,139 @@ void KGlobalAccelPrivate::remove(QAction *action, Removal removal)
             }
         }
     }
+}
+
+KGlobalAccelPrivate::ActionRecord *KGlobalAccelPrivate::record(const QAction *action)
+{
+    const auto it = actionIndex.constFind(action);
+    return it != actionIndex.cend() ? &actionRecords[*it] : nullptr;
+}
+
+const KGlobalAccelPrivate::ActionRecord *KGlobalAccelPrivate::record(const QAction *action) const
+{
+    const auto it = actionIndex.constFind(action);
+    return it != actionIndex.cend() ? &actionRecords.at(*it) : nullptr;
+}
+
+void KGlobalAccelPrivate::eraseRecord(const QAction *action)
+{
+    const auto it = actionIndex.constFind(action);
+    if (it == actionIndex.cend()) {
+        return;
+    }
+    const qsizetype index = *it;
+    actionIndex.erase(it);
+
+    // Keep the records contiguous by moving the last one into the gap
+    const qsizetype last = actionRecords.size() - 1;
+    if (index != last) {
+        actionRecords[index] = std::move(actionRecords[last]);
+        actionIndex[actionRecords.at(index).action] = index;
+    }
+    actionRecords.removeLast();
+}
+
+const QStringList &KGlobalAccelPrivate::actionId(ActionRecord *record)
+{
+    if (record->actionIdStale) {
+        record->actionIdStale = false;
+        // Most changes of an action don't touch its id, keep sharing the data with sentActionId then
+        const QStringList actionId = makeActionId(record->action);
+        if (actionId != record->actionId) {
+            record->actionId = actionId;
+        }
+    }
+    return record->actionId;
+}
+
+void KGlobalAccelPrivate::invalidateActionId(const QAction *action)
+{
+    if (action) {
+        ActionRecord *record = this->record(action);
+        if (!record) {
+            return;
+        }
+        record->actionIdStale = true;
+    } else {
+        for (ActionRecord &record : actionRecords) {
+            record.actionIdStale = true;
+        }
+    }
+    m_actionIdTimer->start();
+}
+
+void KGlobalAccelPrivate::pushChangedFriendlyNames()
+{
+    for (ActionRecord &record : actionRecords) {
+        if (!record.actionIdStale) {
+            continue;
+        }
+        const QStringList &actionId = this->actionId(&record);
+        if (actionId == record.sentActionId) {
+            continue;
+        }
+        // With other unique names it is another shortcut as far as kglobalaccel is concerned,
+        // that is left to the next update of the action
+        if (actionId.at(KGlobalAccel::ComponentUnique) != record.sentActionId.at(KGlobalAccel::ComponentUnique)
+            || actionId.at(KGlobalAccel::ActionUnique) != record.sentActionId.at(KGlobalAccel::ActionUnique)) {
+            continue;
+        }
+        if (batchDepth > 0 || serviceState == ServiceActivating) {
+            if (!pendingRegistrations.contains(record.action)) {
+                pendingRegistrations.append(record.action);
+            }
+            continue;
+        }
+        // kglobalaccel takes the friendly names of an action it already knows from doRegister
+        record.sentActionId = actionId;
+        ipcCounters.countCall(IpcCounters::DoRegister, actionId);
+        iface()->doRegister(actionId);
+    }
+}
 
-    actionDefaultShortcuts.remove(action);
-    actionShortcuts.remove(action);
+bool KGlobalAccelPrivate::hasKeys(ActionRecord *record, ShortcutTypes types, const QList<QKeySequence> &keys)
+{
+    // kglobalaccel knows nothing about the action under other unique names
+    const QStringList &actionId = this->actionId(record);
+    if (actionId.at(KGlobalAccel::ComponentUnique) != record->sentActionId.at(KGlobalAccel::ComponentUnique)
+        || actionId.at(KGlobalAccel::ActionUnique) != record->sentActionId.at(KGlobalAccel::ActionUnique)) {
+        return false;
+    }
+    if ((types & ActiveShortcut) && (!record->hasActiveKeys || record->activeKeys != keys)) {
+        return false;
+    }
+    if ((types & DefaultShortcut) && (!record->hasDefaultKeys || record->defaultKeys != keys)) {
+        return false;
+    }
+    return true;
+}
+
+void KGlobalAccelPrivate::scheduleFlush()
+{
+    if (!m_flushTimer) {
+        m_flushTimer = new QTimer(q);
+        m_flushTimer->setSingleShot(true);
+        m_flushTimer->setInterval(0);
+        QObject::connect(m_flushTimer, &QTimer::timeout, q, [this] {
+            // An open batch flushes everything once it is committed
+            if (batchDepth == 0) {
+                flushBatch();
+            }
+        });
+    }
+    m_flushTimer->start();
 }
 
 void KGlobalAccelPrivate::unregister(const QStringList &actionId)
 {
     const auto component = actionId.at(KGlobalAccel::ComponentUnique);
     const auto action = actionId.at(KGlobalAccel::ActionUnique);
+    shortcutKeysCache.remove(DispatchKey{component, action});
 
     auto message = QDBusMessage::createMethodCall(iface()->service(), iface()->path(), iface()->interface(), QStringLiteral("unregister"));
     message.setArguments({component, action});
     message.setAutoStartService(false);
+    ipcCounters.countCall(IpcCounters::Unregister, component, action);
     m_bus.asyncCall(message);
 }
 
@@ -296,6 +826,7 @@ void KGlobalAccelPrivate::setInactive(const QStringList &actionId)
     auto message = QDBusMessage::createMethodCall(iface()->service(), iface()->path(), iface()->interface(), QStringLiteral("setInactive"));
     message.setArguments({actionId});
     message.setAutoStartService(false);
+    ipcCounters.countCall(IpcCounters::SetInactive, actionId);
     m_bus.asyncCall(message);
 }
 
@@ -308,15 +839,49 @@ void KGlobalAccelPrivate::updateGlobalShortcut(/*const would be better*/ QAction
         return;
     }
 
-    QStringList actionId = makeActionId(action);
+    if (batchDepth > 0 || asynchronousUpdates || !isServiceActive()) {
+        // The keys are read when the batch is flushed, so one entry per action and loading flag is enough.
+        // Asynchronous updates are flushed with the next iteration of the event loop, a burst of
+        // changes to an action only leads to one update. While kglobalaccel is starting up
+        // everything waits for finishActivation().
+        auto it = std::find_if(pendingUpdates.begin(), pendingUpdates.end(), [action, globalFlags](const PendingUpdate &update) {
+            return update.action == action && update.globalFlags == globalFlags;
+        });
+        if (it != pendingUpdates.end()) {
+            it->actionFlags |= actionFlags;
+        } else {
+            pendingUpdates.append(PendingUpdate{action, actionFlags, globalFlags});
+        }
+        if (batchDepth == 0) {
+            scheduleFlush();
+        }
+        return;
+    }
+
+    sendGlobalShortcut(action, actionFlags, globalFlags);
+}
+
+void KGlobalAccelPrivate::sendGlobalShortcut(QAction *action, ShortcutTypes actionFlags, KGlobalAccel::GlobalShortcutLoading globalFlags)
+{
+    ActionRecord *record = this->record(action);
+    if (!record) {
+        return;
+    }
+    // setShortcutKeys ignores the friendly names, changed ones are pushed by pushChangedFriendlyNames()
+    const QStringList actionId = this->actionId(record);
+    markSent(record, actionId);
+    const QList<QKeySequence> activeShortcut = record->activeKeys;
+    const QList<QKeySequence> defaultShortcut = record->defaultKeys;
 
     uint setterFlags = 0;
     if (globalFlags & KGlobalAccel::GlobalShortcutLoading::NoAutoloading) {
         setterFlags |= NoAutoloading;
     }
 
+    // The flags may have changed since the action was registered
+    updateDispatchEntry(action, actionId);
+
     if (actionFlags & ActiveShortcut) {
-        const QList<QKeySequence> activeShortcut = actionShortcuts.value(action);
         bool isConfigurationAction = action->property("isConfigurationAction").toBool();
         uint activeSetterFlags = setterFlags;
 
@@ -326,41 +891,233 @@ void KGlobalAccelPrivate::updateGlobalShortcut(/*const would be better*/ QAction
         }
 
         // Sets the shortcut, returns the active/real keys
+        ipcCounters.countCall(IpcCounters::SetShortcutKeys, actionId, activeShortcut, activeSetterFlags);
         const auto result = iface()->setShortcutKeys(actionId, activeShortcut, activeSetterFlags);
 
-        // Make sure we get informed about changes in the component by kglobalaccel
-        getComponent(componentUniqueForAction(action), true);
+        // Supersedes any reply still in flight for this action
+        const quint64 serial = nextUpdateSerial(action);
+
+        if (asynchronousUpdates) {
+            // Reconcile once kglobalaccel answered, unless the action got a newer shortcut in the meantime
+            auto watcher = new QDBusPendingCallWatcher(result, q);
+            QObject::connect(watcher,
+                             &QDBusPendingCallWatcher::finished,
+                             q,
+                             [this, action = QPointer<QAction>(action), actionId, activeShortcut, isConfigurationAction, globalFlags, serial](
+                                 QDBusPendingCallWatcher *watcher) {
+                                 watcher->deleteLater();
+                                 const QDBusPendingReply<QList<QKeySequence>> reply = *watcher;
+                                 if (!action || !isCurrentUpdate(action, serial)) {
+                                     return;
+                                 }
+                                 if (reply.isError()) {
+                                     qCWarning(KGLOBALACCEL_LOG) << "Failed to set shortcut for" << actionId << reply.error();
+                                     return;
+                                 }
+                                 applyActiveShortcutResult(action, actionId, activeShortcut, reply.value(), isConfigurationAction, globalFlags);
+                             });
+        } else {
+            // Create a shortcut from the result
+            const QList<QKeySequence> scResult = waitForReply<QDBusReply<QList<QKeySequence>>>(IpcCounters::SetShortcutKeys, result).value();
+
+            applyActiveShortcutResult(action, actionId, activeShortcut, scResult, isConfigurationAction, globalFlags);
+        }
+    }
 
-        // Create a shortcut from the result
-        const QList<QKeySequence> scResult(result);
+    if (actionFlags & DefaultShortcut) {
+        ipcCounters.countCall(IpcCounters::SetShortcutKeys, actionId, defaultShortcut, setterFlags | IsDefault);
+        iface()->setShortcutKeys(actionId, defaultShortcut, setterFlags | IsDefault);
+    }
+}
+
+void KGlobalAccelPrivate::applyActiveShortcutResult(QAction *action,
+                                                    const QStringList &actionId,
+                                                    const QList<QKeySequence> &sentKeys,
+                                                    const QList<QKeySequence> &resultKeys,
+                                                    bool isConfigurationAction,
+                                                    KGlobalAccel::GlobalShortcutLoading globalFlags)
+{
+    if (isConfigurationAction && (globalFlags & KGlobalAccel::GlobalShortcutLoading::NoAutoloading)) {
+        // If this is a configuration action and we have set the shortcut,
+        // inform the real owner of the change.
+        // Note that setForeignShortcut will cause a signal to be sent to applications
+        // even if it did not "see" that the shortcut has changed. This is Good because
+        // at the time of comparison (now) the action *already has* the new shortcut.
+        // We called setShortcut(), remember?
+        // Also note that we will see our own signal so we may not need to call
+        // setActiveGlobalShortcutNoEnable - shortcutGotChanged() does it.
+        // In practice it's probably better to get the change propagated here without
+        // DBus delay as we do below.
+        ipcCounters.countCall(IpcCounters::SetForeignShortcutKeys, actionId, resultKeys);
+        iface()->setForeignShortcutKeys(actionId, resultKeys);
+    }
+    // These are the keys kglobalaccel has now, no need to ask it again
+    const auto it = shortcutKeysCache.find(DispatchKey{actionId.at(KGlobalAccel::ComponentUnique), actionId.at(KGlobalAccel::ActionUnique)});
+    if (it != shortcutKeysCache.end()) {
+        *it = resultKeys;
+    }
+    if (resultKeys != sentKeys) {
+        // If kglobalaccel returned a shortcut that differs from the one we
+        // sent, use that one. There must have been clashes or some other problem.
+        if (ActionRecord *record = this->record(action)) {
+            record->activeKeys = resultKeys;
+            record->hasActiveKeys = true;
+            announceShortcutChange(action);
+        }
+    }
+}
 
-        if (isConfigurationAction && (globalFlags & KGlobalAccel::GlobalShortcutLoading::NoAutoloading)) {
-            // If this is a configuration action and we have set the shortcut,
-            // inform the real owner of the change.
-            // Note that setForeignShortcut will cause a signal to be sent to applications
-            // even if it did not "see" that the shortcut has changed. This is Good because
-            // at the time of comparison (now) the action *already has* the new shortcut.
-            // We called setShortcut(), remember?
-            // Also note that we will see our own signal so we may not need to call
-            // setActiveGlobalShortcutNoEnable - shortcutGotChanged() does it.
-            // In practice it's probably better to get the change propagated here without
-            // DBus delay as we do below.
-            iface()->setForeignShortcutKeys(actionId, result);
+void KGlobalAccelPrivate::flushBatch()
+{
+    if (serviceState == ServiceActivating) {
+        // Sent by finishActivation()
+        return;
+    }
+    const QList<QPointer<QAction>> registrations = std::exchange(pendingRegistrations, {});
+    const QList<PendingUpdate> updates = std::exchange(pendingUpdates, {});
+
+    if (batchUnsupported) {
+        // kglobalaccel is too old for setShortcutKeysBatch, do what we would have done without a batch
+        for (QAction *action : registrations) {
+            if (ActionRecord *record = this->record(action)) {
+                markSent(record, actionId(record));
+                ipcCounters.countCall(IpcCounters::DoRegister, record->sentActionId);
+                iface()->doRegister(record->sentActionId);
+            }
         }
-        if (scResult != activeShortcut) {
-            // If kglobalaccel returned a shortcut that differs from the one we
-            // sent, use that one. There must have been clashes or some other problem.
-            actionShortcuts.insert(action, scResult);
-            Q_EMIT q->globalShortcutChanged(action, scResult.isEmpty() ? QKeySequence() : scResult.first());
+        for (const PendingUpdate &update : updates) {
+            if (update.action && isRegistered(update.action)) {
+                sendGlobalShortcut(update.action, update.actionFlags, update.globalFlags);
+            }
         }
+        return;
     }
 
-    if (actionFlags & DefaultShortcut) {
-        const QList<QKeySequence> defaultShortcut = actionDefaultShortcuts.value(action);
-        iface()->setShortcutKeys(actionId, defaultShortcut, setterFlags | IsDefault);
+    QList<BatchEntry> entries;
+
+    QList<QStringList> actionIds;
+    QList<QList<QKeySequence>> keys;
+    QList<uint> flags;
+    QSet<QAction *> sentActions;
+
+    for (const PendingUpdate &update : updates) {
+        QAction *action = update.action;
+        ActionRecord *record = this->record(action);
+        if (!record) {
+            continue;
+        }
+
+        const QStringList actionId = this->actionId(record);
+        markSent(record, actionId);
+        sentActions.insert(action);
+        updateDispatchEntry(action, actionId);
+
+        uint setterFlags = 0;
+        if (update.globalFlags & KGlobalAccel::GlobalShortcutLoading::NoAutoloading) {
+            setterFlags |= NoAutoloading;
+        }
+
+        // Same order as in updateGlobalShortcut(), the active keys go first
+        if (update.actionFlags & ActiveShortcut) {
+            const bool isConfigurationAction = action->property("isConfigurationAction").toBool();
+            const QList<QKeySequence> activeShortcut = record->activeKeys;
+
+            actionIds.append(actionId);
+            keys.append(activeShortcut);
+            flags.append(isConfigurationAction ? setterFlags : setterFlags | SetPresent);
+            entries.append(BatchEntry{action, actionId, activeShortcut, isConfigurationAction, update.globalFlags, nextUpdateSerial(action)});
+        }
+
+        if (update.actionFlags & DefaultShortcut) {
+            actionIds.append(actionId);
+            keys.append(record->defaultKeys);
+            flags.append(setterFlags | IsDefault);
+            // Nothing to apply for default keys, this only keeps the entries aligned with the results
+            entries.append(BatchEntry{nullptr, {}, {}, false, update.globalFlags, 0});
+        }
+    }
+
+    // Actions that were registered but never got a shortcut only need the registration
+    for (QAction *action : registrations) {
+        ActionRecord *record = this->record(action);
+        if (record && !sentActions.contains(action)) {
+            markSent(record, actionId(record));
+            ipcCounters.countCall(IpcCounters::DoRegister, record->sentActionId);
+            iface()->doRegister(record->sentActionId);
+        }
+    }
+
+    if (actionIds.isEmpty()) {
+        return;
+    }
+
+    ipcCounters.countCall(IpcCounters::SetShortcutKeysBatch, actionIds, keys, flags);
+    QDBusPendingCall call = iface()->setShortcutKeysBatch(actionIds, keys, flags);
+    if (asynchronousUpdates) {
+        auto watcher = new QDBusPendingCallWatcher(call, q);
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished, q, [this, entries, registrations, updates](QDBusPendingCallWatcher *watcher) {
+            watcher->deleteLater();
+            finishBatch(*watcher, entries, registrations, updates);
+        });
+    } else {
+        {
+            const auto blocked = ipcCounters.blocking(IpcCounters::SetShortcutKeysBatch);
+            call.waitForFinished();
+        }
+        finishBatch(call, entries, registrations, updates);
     }
 }
 
+void KGlobalAccelPrivate::finishBatch(const QDBusPendingCall &call,
+                                      const QList<BatchEntry> &entries,
+                                      const QList<QPointer<QAction>> &registrations,
+                                      const QList<PendingUpdate> &updates)
+{
+    const QDBusPendingReply<QList<QList<QKeySequence>>> reply = call;
+    if (reply.isError()) {
+        if (reply.error().type() != QDBusError::UnknownMethod) {
+            qCWarning(KGLOBALACCEL_LOG) << "Failed to register shortcuts with kglobalaccel" << reply.error();
+            return;
+        }
+        qCDebug(KGLOBALACCEL_LOG) << "kglobalaccel doesn't support setShortcutKeysBatch, registering shortcuts one by one";
+        batchUnsupported = true;
+        // Anything queued in the meantime goes after the entries of the failed batch
+        pendingRegistrations = registrations + pendingRegistrations;
+        pendingUpdates = updates + pendingUpdates;
+        if (batchDepth == 0) {
+            flushBatch();
+        }
+        return;
+    }
+
+    const QList<QList<QKeySequence>> results = reply.value();
+    if (results.size() != entries.size()) {
+        qCWarning(KGLOBALACCEL_LOG) << "kglobalaccel returned" << results.size() << "results for" << entries.size() << "shortcuts";
+        return;
+    }
+    for (qsizetype i = 0; i < results.size(); ++i) {
+        const BatchEntry &entry = entries.at(i);
+        if (entry.action && isCurrentUpdate(entry.action, entry.serial)) {
+            applyActiveShortcutResult(entry.action, entry.actionId, entry.keys, results.at(i), entry.isConfigurationAction, entry.globalFlags);
+        }
+    }
+}
+
+quint64 KGlobalAccelPrivate::nextUpdateSerial(const QAction *action)
+{
+    const quint64 serial = ++lastUpdateSerial;
+    if (ActionRecord *record = this->record(action)) {
+        record->updateSerial = serial;
+    }
+    return serial;
+}
+
+bool KGlobalAccelPrivate::isCurrentUpdate(const QAction *action, quint64 serial) const
+{
+    const ActionRecord *record = this->record(action);
+    return record && record->updateSerial == serial;
+}
+
 QStringList KGlobalAccelPrivate::makeActionId(const QAction *action)
 {
     QStringList ret(componentUniqueForAction(action)); // Component Unique Id ( see actionIdFields )
@@ -428,32 +1185,93 @@ int timestampCompare(unsigned long time1_, unsigned long time2_) // like strcmp(
 }
 #endif
 
-QAction *KGlobalAccelPrivate::findAction(const QString &componentUnique, const QString &actionUnique)
+void KGlobalAccelPrivate::updateDispatchEntry(QAction *action, const QStringList &actionId)
 {
-    QAction *action = nullptr;
-    const QList<QAction *> candidates = nameToAction.values(actionUnique);
-    for (QAction *const a : candidates) {
-        if (componentUniqueForAction(a) == componentUnique) {
-            action = a;
+    ActionRecord *record = this->record(action);
+    if (!record) {
+        return;
+    }
+    const DispatchKey key{actionId.at(KGlobalAccel::ComponentUnique), actionId.at(KGlobalAccel::ActionUnique)};
+    if (key != record->dispatchKey) {
+        removeDispatchEntry(record);
+        record->dispatchKey = key;
+    }
+
+    const DispatchEntry entry{action, record->registration, action->isEnabled(), action->property("isConfigurationAction").toBool()};
+    QList<DispatchEntry> &entries = dispatchIndex[key];
+    const auto it = std::find_if(entries.begin(), entries.end(), [&entry](const DispatchEntry &other) {
+        return other.registration >= entry.registration;
+    });
+    if (it != entries.end() && it->action == action) {
+        *it = entry;
+    } else {
+        entries.insert(it, entry);
+    }
+}
+
+void KGlobalAccelPrivate::removeDispatchEntry(const ActionRecord *record)
+{
+    const auto it = dispatchIndex.find(record->dispatchKey);
+    if (it == dispatchIndex.end()) {
+        return;
+    }
+    it->removeIf([action = record->action](const DispatchEntry &entry) {
+        return entry.action == action;
+    });
+    if (it->isEmpty()) {
+        dispatchIndex.erase(it);
+    }
+}
+
+KGlobalAccelPrivate::DispatchEntry *KGlobalAccelPrivate::dispatchEntry(const QAction *action)
+{
+    const ActionRecord *record = this->record(action);
+    if (!record) {
+        return nullptr;
+    }
+    const auto it = dispatchIndex.find(record->dispatchKey);
+    if (it == dispatchIndex.end()) {
+        return nullptr;
+    }
+    for (DispatchEntry &entry : *it) {
+        if (entry.action == action) {
+            return &entry;
         }
     }
+    return nullptr;
+}
+
+QAction *KGlobalAccelPrivate::findAction(const QString &componentUnique, const QString &actionUnique)
+{
+    // Copying the strings into the key only touches their reference counts
+    const auto it = dispatchIndex.constFind(DispatchKey{componentUnique, actionUnique});
+    if (it == dispatchIndex.cend() || it->isEmpty()) {
+        return nullptr;
+    }
+    // If several actions have the same names the one registered first gets the shortcut,
+    // the others take over when it is removed
+    const DispatchEntry &entry = it->constFirst();
 
     // We do not trigger if
     // - there is no action
     // - the action is not enabled
     // - the action is an configuration action
-    if (!action || !action->isEnabled() || action->property("isConfigurationAction").toBool()) {
+    if (!entry.enabled || entry.isConfigurationAction) {
         return nullptr;
     }
-    return action;
+    return entry.action;
 }
 
 void KGlobalAccelPrivate::invokeAction(const QString &componentUnique, const QString &actionUnique, qlonglong timestamp, ShortcutState state)
 {
+    const bool measure = latency.isEnabled();
+    const auto received = measure ? ShortcutLatencyRecorder::Clock::now() : ShortcutLatencyRecorder::Clock::time_point();
+
     QAction *action = findAction(componentUnique, actionUnique);
     if (!action) {
         return;
     }
+    const auto lookedUp = measure ? ShortcutLatencyRecorder::Clock::now() : ShortcutLatencyRecorder::Clock::time_point();
 
 #if WITH_X11
     // Update this application's X timestamp if needed.
@@ -475,72 +1293,413 @@ void KGlobalAccelPrivate::invokeAction(const QString &componentUnique, const QSt
         Q_EMIT q->globalShortcutActiveChanged(action, true);
         m_lastActivatedAction = action;
     }
-    if (!action->autoRepeat() && state == ShortcutState::Repeated) {
-        return;
+    if (action->autoRepeat() || state != ShortcutState::Repeated) {
+        action->trigger();
+    }
+
+    if (measure) {
+        latency.record(componentUnique,
+                       actionUnique,
+                       state == ShortcutState::Repeated ? ShortcutLatencyRecorder::Repeated : ShortcutLatencyRecorder::Pressed,
+                       timestamp,
+                       received,
+                       lookedUp,
+                       ShortcutLatencyRecorder::Clock::now());
     }
-    action->trigger();
 }
 
-void KGlobalAccelPrivate::invokeDeactivate(const QString &componentUnique, const QString &actionUnique)
+void KGlobalAccelPrivate::invokeDeactivate(const QString &componentUnique, const QString &actionUnique, qlonglong timestamp)
 {
+    const bool measure = latency.isEnabled();
+    const auto received = measure ? ShortcutLatencyRecorder::Clock::now() : ShortcutLatencyRecorder::Clock::time_point();
+
     QAction *action = findAction(componentUnique, actionUnique);
     if (!action) {
         return;
     }
+    const auto lookedUp = measure ? ShortcutLatencyRecorder::Clock::now() : ShortcutLatencyRecorder::Clock::time_point();
 
     m_lastActivatedAction.clear();
 
     Q_EMIT q->globalShortcutActiveChanged(action, false);
+
+    if (measure) {
+        latency.record(componentUnique, actionUnique, ShortcutLatencyRecorder::Released, timestamp, received, lookedUp, ShortcutLatencyRecorder::Clock::now());
+    }
 }
 
 void KGlobalAccelPrivate::shortcutsChanged(const QStringList &actionId, const QList<QKeySequence> &keys)
 {
-    QAction *action = nameToAction.value(actionId.at(KGlobalAccel::ActionUnique));
-    if (!action) {
+    // kglobalaccel broadcasts this, so it keeps the cache current for other applications' shortcuts too
+    const auto it = shortcutKeysCache.find(DispatchKey{actionId.at(KGlobalAccel::ComponentUnique), actionId.at(KGlobalAccel::ActionUnique)});
+    if (it != shortcutKeysCache.end()) {
+        *it = keys;
+    }
+
+    const auto entry = dispatchIndex.constFind(DispatchKey{actionId.at(KGlobalAccel::ComponentUnique), actionId.at(KGlobalAccel::ActionUnique)});
+    if (entry == dispatchIndex.cend() || entry->isEmpty()) {
         return;
     }
+    // The action that gets the shortcut, see findAction()
+    QAction *action = entry->constFirst().action;
+    ActionRecord *record = this->record(action);
+    if (!record) {
+        return;
+    }
+    record->activeKeys = keys;
+    record->hasActiveKeys = true;
+    announceShortcutChange(action);
+}
 
-    actionShortcuts.insert(action, keys);
-    Q_EMIT q->globalShortcutChanged(action, keys.isEmpty() ? QKeySequence() : keys.first());
+void KGlobalAccelPrivate::announceShortcutChange(QAction *action)
+{
+    if (!coalesceShortcutChanges) {
+        const QList<QKeySequence> keys = record(action)->activeKeys;
+        Q_EMIT q->globalShortcutChanged(action, keys.isEmpty() ? QKeySequence() : keys.first());
+        Q_EMIT q->globalShortcutsChanged({action});
+        return;
+    }
+
+    // Announced once the burst of changes is over, see flushShortcutChanges()
+    if (!changedActions.contains(action)) {
+        changedActions.append(action);
+    }
+    if (!m_changeNotificationTimer) {
+        m_changeNotificationTimer = new QTimer(q);
+        m_changeNotificationTimer->setSingleShot(true);
+        m_changeNotificationTimer->setInterval(0);
+        QObject::connect(m_changeNotificationTimer, &QTimer::timeout, q, [this] {
+            flushShortcutChanges();
+        });
+    }
+    m_changeNotificationTimer->start();
+}
+
+void KGlobalAccelPrivate::flushShortcutChanges()
+{
+    if (m_changeNotificationTimer) {
+        m_changeNotificationTimer->stop();
+    }
+
+    QList<QAction *> changed;
+    changed.reserve(changedActions.size());
+    const QList<QPointer<QAction>> pending = std::exchange(changedActions, {});
+    for (QAction *action : pending) {
+        // Removed actions don't have a shortcut to announce anymore
+        const ActionRecord *record = this->record(action);
+        if (!record) {
+            continue;
+        }
+        const QList<QKeySequence> keys = record->activeKeys;
+        Q_EMIT q->globalShortcutChanged(action, keys.isEmpty() ? QKeySequence() : keys.first());
+        changed.append(action);
+    }
+    if (!changed.isEmpty()) {
+        Q_EMIT q->globalShortcutsChanged(changed);
+    }
 }
 
 void KGlobalAccelPrivate::serviceOwnerChanged(const QString &name, const QString &oldOwner, const QString &newOwner)
 {
-    Q_UNUSED(oldOwner);
-    if (name == QLatin1String("org.kde.kglobalaccel") && !newOwner.isEmpty()) {
-        // kglobalaccel was restarted
-        qCDebug(KGLOBALACCEL_LOG) << "detected kglobalaccel restarting, re-registering all shortcut keys";
-        reRegisterAll();
+    if (name != QLatin1String("org.kde.kglobalaccel")) {
+        return;
+    }
+    if (newOwner.isEmpty()) {
+        // Everything is restored when it comes back
+        serviceLost = true;
+        return;
+    }
+    if (serviceState == ServiceActivating) {
+        // The instance activateService() asked for, or the first one after it failed to start
+        // one. All it needs to know was queued.
+        serviceLost = false;
+        finishActivation();
+        return;
     }
+    if (oldOwner.isEmpty() && !serviceLost) {
+        // The same, after a blocking call or the reply to StartServiceByName ended the activation
+        return;
+    }
+    serviceLost = false;
+    // kglobalaccel was restarted
+    qCDebug(KGLOBALACCEL_LOG) << "detected kglobalaccel restarting, re-registering all shortcut keys";
+    // The new instance may know setShortcutKeysBatch
+    batchUnsupported = false;
+    infoTablesUnsupported = false;
+    // and nothing guarantees it has the same keys as the old one
+    shortcutKeysCache.clear();
+
+    ipcCounters.countRestart();
+
+    // Every application gets this notification at the same time. Spread the load a bit
+    // instead of having all of them call the new instance in the same instant.
+    const quint64 generation = ++restoreGeneration;
+    QTimer::singleShot(restoreJitter(), q, [this, generation] {
+        if (generation == restoreGeneration) {
+            reRegisterAll();
+        }
+    });
 }
 
 void KGlobalAccelPrivate::reRegisterAll()
 {
-    // We clear all our data, assume that all data on the other side is clear too,
-    // and register each action as if it just was allowed to have global shortcuts.
+    // We assume that all data on the other side is clear, and register each action as if it
+    // just was allowed to have global shortcuts.
     // If the kded side still has the data it doesn't matter because of the
     // autoloading mechanism. The worst case I can imagine is that an action's
     // shortcut was changed but the kded side died before it got the message so
     // autoloading will now assign an old shortcut to the action. Particularly
     // picky apps might assert or misbehave.
-    const QSet<QAction *> allActions = actions;
-    nameToAction.clear();
-    actions.clear();
-    for (QAction *const action : allActions) {
-        if (doRegister(action)) {
-            updateGlobalShortcut(action, ActiveShortcut, KGlobalAccel::Autoloading);
+    // Our own bookkeeping stays valid, so shortcuts keep being dispatched while this is going on.
+    // Nothing here blocks, there is one call per component and the replies are applied as they come in.
+    const quint64 generation = restoreGeneration;
+
+    QHash<QString, QList<QPointer<QAction>>> actionsByComponent;
+    for (const ActionRecord &record : std::as_const(actionRecords)) {
+        actionsByComponent[record.sentActionId.at(KGlobalAccel::ComponentUnique)].append(record.action);
+    }
+
+    pendingRestores = actionsByComponent.size();
+    if (pendingRestores == 0) {
+        Q_EMIT q->globalShortcutsRestored();
+        return;
+    }
+    for (auto it = actionsByComponent.cbegin(); it != actionsByComponent.cend(); ++it) {
+        restoreComponent(generation, it.key(), it.value(), 0);
+    }
+}
+
+void KGlobalAccelPrivate::restoreComponent(quint64 generation,
+                                           const QString &componentUnique,
+                                           const QList<QPointer<QAction>> &componentActions,
+                                           int attempt)
+{
+    if (batchUnsupported) {
+        restoreComponentOneByOne(generation, componentActions);
+        return;
+    }
+
+    QList<BatchEntry> entries;
+    QList<QStringList> actionIds;
+    QList<QList<QKeySequence>> keys;
+    QList<uint> flags;
+
+    for (QAction *action : componentActions) {
+        ActionRecord *record = this->record(action);
+        if (!record) {
+            continue;
+        }
+        const QStringList actionId = this->actionId(record);
+        markSent(record, actionId);
+        const bool isConfigurationAction = action->property("isConfigurationAction").toBool();
+        const QList<QKeySequence> activeShortcut = record->activeKeys;
+
+        actionIds.append(actionId);
+        keys.append(activeShortcut);
+        flags.append(isConfigurationAction ? 0 : uint(SetPresent));
+        entries.append(BatchEntry{action, actionId, activeShortcut, isConfigurationAction, KGlobalAccel::Autoloading, nextUpdateSerial(action)});
+    }
+
+    if (entries.isEmpty()) {
+        finishRestore(generation);
+        return;
+    }
+
+    ipcCounters.countCall(IpcCounters::SetShortcutKeysBatch, actionIds, keys, flags);
+    auto watcher = new QDBusPendingCallWatcher(iface()->setShortcutKeysBatch(actionIds, keys, flags), q);
+    QObject::connect(watcher,
+                     &QDBusPendingCallWatcher::finished,
+                     q,
+                     [this, generation, componentUnique, componentActions, attempt, entries](QDBusPendingCallWatcher *watcher) {
+                         watcher->deleteLater();
+                         // Nothing to do if kglobalaccel restarted once more, a newer restore takes care of it
+                         if (generation == restoreGeneration) {
+                             restoreComponentFinished(*watcher, generation, componentUnique, componentActions, attempt, entries);
+                         }
+                     });
+}
+
+void KGlobalAccelPrivate::restoreComponentFinished(const QDBusPendingCall &call,
+                                                   quint64 generation,
+                                                   const QString &componentUnique,
+                                                   const QList<QPointer<QAction>> &componentActions,
+                                                   int attempt,
+                                                   const QList<BatchEntry> &entries)
+{
+    const QDBusPendingReply<QList<QList<QKeySequence>>> reply = call;
+    if (reply.isError()) {
+        if (reply.error().type() == QDBusError::UnknownMethod) {
+            batchUnsupported = true;
+            restoreComponentOneByOne(generation, componentActions);
+            return;
+        }
+        if (attempt + 1 < s_restoreAttempts) {
+            // Most likely the new instance is still busy starting up, back off
+            const auto delay = s_restoreRetryDelay * (1 << attempt) + restoreJitter();
+            qCDebug(KGLOBALACCEL_LOG) << "Failed to restore shortcuts of" << componentUnique << reply.error() << "retrying in" << delay.count() << "ms";
+            QTimer::singleShot(delay, q, [this, generation, componentUnique, componentActions, attempt] {
+                if (generation == restoreGeneration) {
+                    restoreComponent(generation, componentUnique, componentActions, attempt + 1);
+                }
+            });
+            return;
         }
+        qCWarning(KGLOBALACCEL_LOG) << "Failed to restore shortcuts of" << componentUnique << reply.error();
+        finishRestore(generation);
+        return;
+    }
+
+    const QList<QList<QKeySequence>> results = reply.value();
+    if (results.size() != entries.size()) {
+        qCWarning(KGLOBALACCEL_LOG) << "kglobalaccel returned" << results.size() << "results for" << entries.size() << "shortcuts";
+        finishRestore(generation);
+        return;
+    }
+    for (qsizetype i = 0; i < results.size(); ++i) {
+        const BatchEntry &entry = entries.at(i);
+        if (entry.action && isCurrentUpdate(entry.action, entry.serial)) {
+            applyActiveShortcutResult(entry.action, entry.actionId, entry.keys, results.at(i), entry.isConfigurationAction, entry.globalFlags);
+        }
+    }
+    finishRestore(generation);
+}
+
+void KGlobalAccelPrivate::restoreComponentOneByOne(quint64 generation, const QList<QPointer<QAction>> &componentActions)
+{
+    // Still asynchronous, all calls are sent right away and the replies are collected as they arrive
+    auto remaining = std::make_shared<int>(0);
+    for (QAction *action : componentActions) {
+        ActionRecord *record = this->record(action);
+        if (!record) {
+            continue;
+        }
+        const QStringList actionId = this->actionId(record);
+        markSent(record, actionId);
+        const bool isConfigurationAction = action->property("isConfigurationAction").toBool();
+        const QList<QKeySequence> activeShortcut = record->activeKeys;
+        const quint64 serial = nextUpdateSerial(action);
+
+        const uint setterFlags = isConfigurationAction ? 0 : uint(SetPresent);
+        ipcCounters.countCall(IpcCounters::DoRegister, actionId);
+        iface()->doRegister(actionId);
+        ipcCounters.countCall(IpcCounters::SetShortcutKeys, actionId, activeShortcut, setterFlags);
+        auto watcher = new QDBusPendingCallWatcher(iface()->setShortcutKeys(actionId, activeShortcut, setterFlags), q);
+        ++*remaining;
+        QObject::connect(watcher,
+                         &QDBusPendingCallWatcher::finished,
+                         q,
+                         [this, generation, remaining, action = QPointer<QAction>(action), actionId, activeShortcut, isConfigurationAction, serial](
+                             QDBusPendingCallWatcher *watcher) {
+                             watcher->deleteLater();
+                             if (generation != restoreGeneration) {
+                                 return;
+                             }
+                             const QDBusPendingReply<QList<QKeySequence>> reply = *watcher;
+                             if (reply.isError()) {
+                                 qCWarning(KGLOBALACCEL_LOG) << "Failed to restore shortcut for" << actionId << reply.error();
+                             } else if (action && isCurrentUpdate(action, serial)) {
+                                 applyActiveShortcutResult(action, actionId, activeShortcut, reply.value(), isConfigurationAction, KGlobalAccel::Autoloading);
+                             }
+                             if (--*remaining == 0) {
+                                 finishRestore(generation);
+                             }
+                         });
+    }
+
+    if (*remaining == 0) {
+        finishRestore(generation);
+    }
+}
+
+void KGlobalAccelPrivate::finishRestore(quint64 generation)
+{
+    if (generation != restoreGeneration) {
+        return;
+    }
+    if (--pendingRestores == 0) {
+        qCDebug(KGLOBALACCEL_LOG) << "all shortcut keys re-registered with kglobalaccel";
+        Q_EMIT q->globalShortcutsRestored();
     }
 }
 
 QList<KGlobalShortcutInfo> KGlobalAccel::globalShortcutsByKey(const QKeySequence &seq, MatchType type)
 {
-    return self()->d->iface()->globalShortcutsByKey(seq, type);
+    KGlobalAccelPrivate *const d = self()->d;
+    d->prepareBlockingCall();
+    if (!d->infoTablesUnsupported) {
+        d->ipcCounters.countCall(IpcCounters::GlobalShortcutsByKeyTable, seq, type);
+        const QDBusReply<KGlobalShortcutInfoTable> reply =
+            d->waitForReply<QDBusReply<KGlobalShortcutInfoTable>>(IpcCounters::GlobalShortcutsByKeyTable, d->iface()->globalShortcutsByKeyTable(seq, type));
+        if (reply.error().type() != QDBusError::UnknownMethod) {
+            return reply.value().infos();
+        }
+        qCDebug(KGLOBALACCEL_LOG) << "kglobalaccel doesn't support globalShortcutsByKeyTable, using globalShortcutsByKey";
+        d->infoTablesUnsupported = true;
+    }
+    d->ipcCounters.countCall(IpcCounters::GlobalShortcutsByKey, seq, type);
+    return d->waitForReply<QDBusReply<QList<KGlobalShortcutInfo>>>(IpcCounters::GlobalShortcutsByKey, d->iface()->globalShortcutsByKey(seq, type)).value();
 }
 
 bool KGlobalAccel::isGlobalShortcutAvailable(const QKeySequence &seq, const QString &comp)
 {
-    return self()->d->iface()->globalShortcutAvailable(seq, comp);
+    KGlobalAccelPrivate *const d = self()->d;
+    d->prepareBlockingCall();
+    d->ipcCounters.countCall(IpcCounters::GlobalShortcutAvailable, seq, comp);
+    return d->waitForReply<QDBusReply<bool>>(IpcCounters::GlobalShortcutAvailable, d->iface()->globalShortcutAvailable(seq, comp)).value();
+}
+
+// static
+QFuture<QList<KGlobalShortcutInfo>> KGlobalAccel::globalShortcutsByKeyAsync(const QKeySequence &seq, MatchType type)
+{
+    KGlobalAccelPrivate *const d = self()->d;
+    if (!d->infoTablesUnsupported) {
+        using Infos = std::optional<QList<KGlobalShortcutInfo>>;
+        d->ipcCounters.countCall(IpcCounters::GlobalShortcutsByKeyTable, seq, type);
+        const QFuture<Infos> table = d->futureForCall<Infos>(d->iface()->globalShortcutsByKeyTable(seq, type), [d](const QDBusPendingCall &call) -> Infos {
+            const QDBusPendingReply<KGlobalShortcutInfoTable> reply = call;
+            if (!reply.isError()) {
+                return reply.value().infos();
+            }
+            if (reply.error().type() != QDBusError::UnknownMethod) {
+                qCDebug(KGLOBALACCEL_LOG) << "Failed to look up global shortcuts" << reply.error();
+                return QList<KGlobalShortcutInfo>();
+            }
+            qCDebug(KGLOBALACCEL_LOG) << "kglobalaccel doesn't support globalShortcutsByKeyTable, using globalShortcutsByKey";
+            d->infoTablesUnsupported = true;
+            return std::nullopt;
+        });
+        return table
+            .then(d->q,
+                  [seq, type](const Infos &infos) {
+                      // Ask again with the old method if kglobalaccel didn't know the new one
+                      return infos ? QtFuture::makeReadyValueFuture(*infos) : globalShortcutsByKeyAsync(seq, type);
+                  })
+            .unwrap();
+    }
+    d->ipcCounters.countCall(IpcCounters::GlobalShortcutsByKey, seq, type);
+    return d->futureForCall<QList<KGlobalShortcutInfo>>(d->iface()->globalShortcutsByKey(seq, type), [](const QDBusPendingCall &call) {
+        const QDBusPendingReply<QList<KGlobalShortcutInfo>> reply = call;
+        if (reply.isError()) {
+            qCDebug(KGLOBALACCEL_LOG) << "Failed to look up global shortcuts" << reply.error();
+            return QList<KGlobalShortcutInfo>();
+        }
+        return reply.value();
+    });
+}
+
+// static
+QFuture<bool> KGlobalAccel::isGlobalShortcutAvailableAsync(const QKeySequence &seq, const QString &comp)
+{
+    KGlobalAccelPrivate *const d = self()->d;
+    d->ipcCounters.countCall(IpcCounters::GlobalShortcutAvailable, seq, comp);
+    return d->futureForCall<bool>(d->iface()->globalShortcutAvailable(seq, comp), [](const QDBusPendingCall &call) {
+        const QDBusPendingReply<bool> reply = call;
+        if (reply.isError()) {
+            qCDebug(KGLOBALACCEL_LOG) << "Failed to check global shortcut availability" << reply.error();
+            return false;
+        }
+        return reply.value();
+    });
 }
 
 // static
@@ -590,7 +1749,9 @@ void KGlobalAccel::stealShortcutSystemwide(const QKeySequence &seq)
         QList<QKeySequence> keySequences = globalShortcut.keys();
         keySequences.removeAll(seq);
 
+        self()->d->ipcCounters.countCall(IpcCounters::SetForeignShortcutKeys, actionId, keySequences);
         self()->d->iface()->setForeignShortcutKeys(actionId, keySequences);
+        self()->d->shortcutKeysCache.remove({actionId.at(ComponentUnique), actionId.at(ActionUnique)});
     }
 }
 
@@ -619,7 +1780,12 @@ bool KGlobalAccel::setDefaultShortcut(QAction *action, const QList<QKeySequence>
         return false;
     }
 
-    d->actionDefaultShortcuts.insert(action, shortcut);
+    KGlobalAccelPrivate::ActionRecord *record = d->record(action);
+    if (d->hasKeys(record, KGlobalAccelPrivate::DefaultShortcut, shortcut)) {
+        return true;
+    }
+    record->defaultKeys = shortcut;
+    record->hasDefaultKeys = true;
     d->updateGlobalShortcut(action, KGlobalAccelPrivate::DefaultShortcut, loadFlag);
     return true;
 }
@@ -634,19 +1800,26 @@ bool KGlobalAccel::setShortcut(QAction *action, const QList<QKeySequence> &short
         return false;
     }
 
-    d->actionShortcuts.insert(action, shortcut);
+    KGlobalAccelPrivate::ActionRecord *record = d->record(action);
+    if (d->hasKeys(record, KGlobalAccelPrivate::ActiveShortcut, shortcut)) {
+        return true;
+    }
+    record->activeKeys = shortcut;
+    record->hasActiveKeys = true;
     d->updateGlobalShortcut(action, KGlobalAccelPrivate::ActiveShortcut, loadFlag);
     return true;
 }
 
 QList<QKeySequence> KGlobalAccel::defaultShortcut(const QAction *action) const
 {
-    return d->actionDefaultShortcuts.value(action);
+    const KGlobalAccelPrivate::ActionRecord *record = d->record(action);
+    return record ? record->defaultKeys : QList<QKeySequence>();
 }
 
 QList<QKeySequence> KGlobalAccel::shortcut(const QAction *action) const
 {
-    return d->actionShortcuts.value(action);
+    const KGlobalAccelPrivate::ActionRecord *record = d->record(action);
+    return record ? record->activeKeys : QList<QKeySequence>();
 }
 
 QList<QKeySequence> KGlobalAccel::globalShortcut(const QString &componentName, const QString &actionId) const
@@ -657,8 +1830,22 @@ QList<QKeySequence> KGlobalAccel::globalShortcut(const QString &componentName, c
     // action->setProperty("componentName", "kwin");
     // action->setObjectName("Kill Window");
 
-    const QList<QKeySequence> scResult = self()->d->iface()->shortcutKeys({componentName, actionId, QString(), QString()});
-    return scResult;
+    KGlobalAccelPrivate *const d = self()->d;
+    const KGlobalAccelPrivate::DispatchKey key{componentName, actionId};
+    const auto it = d->shortcutKeysCache.constFind(key);
+    if (it != d->shortcutKeysCache.cend()) {
+        return *it;
+    }
+
+    const QStringList fullActionId{componentName, actionId, QString(), QString()};
+    d->prepareBlockingCall();
+    d->ipcCounters.countCall(IpcCounters::ShortcutKeys, fullActionId);
+    const auto reply = d->waitForReply<QDBusReply<QList<QKeySequence>>>(IpcCounters::ShortcutKeys, d->iface()->shortcutKeys(fullActionId));
+    if (!reply.isValid()) {
+        return {};
+    }
+    d->shortcutKeysCache.insert(key, reply.value());
+    return reply.value();
 }
 
 void KGlobalAccel::removeAllShortcuts(QAction *action)
@@ -668,7 +1855,8 @@ void KGlobalAccel::removeAllShortcuts(QAction *action)
 
 bool KGlobalAccel::hasShortcut(const QAction *action) const
 {
-    return d->actionShortcuts.contains(action) || d->actionDefaultShortcuts.contains(action);
+    const KGlobalAccelPrivate::ActionRecord *record = d->record(action);
+    return record && (record->hasActiveKeys || record->hasDefaultKeys);
 }
 
 bool KGlobalAccel::setGlobalShortcut(QAction *action, const QList<QKeySequence> &shortcut)
@@ -692,8 +1880,14 @@ bool KGlobalAccelPrivate::setShortcutWithDefault(QAction *action, const QList<QK
         return false;
     }
 
-    actionDefaultShortcuts.insert(action, shortcut);
-    actionShortcuts.insert(action, shortcut);
+    ActionRecord *record = this->record(action);
+    if (hasKeys(record, DefaultShortcut | ActiveShortcut, shortcut)) {
+        return true;
+    }
+    record->defaultKeys = shortcut;
+    record->activeKeys = shortcut;
+    record->hasDefaultKeys = true;
+    record->hasActiveKeys = true;
     updateGlobalShortcut(action, KGlobalAccelPrivate::DefaultShortcut | KGlobalAccelPrivate::ActiveShortcut, loadFlag);
     return true;
 }
@@ -702,12 +1896,13 @@ bool KGlobalAccel::setInverseShortcutActions(QAction *forwardAction, QAction *ba
 {
     KGlobalAccelPrivate *d = self()->d;
 
-    const bool bothRegistered = d->actions.contains(forwardAction) && d->actions.contains(backwardAction);
-    if (!bothRegistered) {
+    KGlobalAccelPrivate::ActionRecord *forwardRecord = d->record(forwardAction);
+    KGlobalAccelPrivate::ActionRecord *backwardRecord = d->record(backwardAction);
+    if (!forwardRecord || !backwardRecord) {
         return false;
     }
-    const QStringList forwardActionId = d->makeActionId(forwardAction);
-    const QStringList backwardActionId = d->makeActionId(backwardAction);
+    const QStringList forwardActionId = d->actionId(forwardRecord);
+    const QStringList backwardActionId = d->actionId(backwardRecord);
 
     if (forwardActionId.at(KGlobalAccel::ComponentUnique) != backwardActionId.at(KGlobalAccel::ComponentUnique)) {
         return false;
@@ -715,10 +1910,74 @@ bool KGlobalAccel::setInverseShortcutActions(QAction *forwardAction, QAction *ba
 
     uint inverseSetterFlags = 0; // reserved
 
-    return d->iface()->setInverseShortcutActions(forwardActionId.at(KGlobalAccel::ComponentUnique),
-                                                 forwardActionId.at(KGlobalAccel::ActionUnique),
-                                                 backwardActionId.at(KGlobalAccel::ActionUnique),
-                                                 inverseSetterFlags);
+    // kglobalaccel has to know both actions
+    d->prepareBlockingCall();
+    d->ipcCounters.countCall(IpcCounters::SetInverseShortcutActions,
+                             forwardActionId.at(KGlobalAccel::ComponentUnique),
+                             forwardActionId.at(KGlobalAccel::ActionUnique),
+                             backwardActionId.at(KGlobalAccel::ActionUnique),
+                             inverseSetterFlags);
+    const auto reply = d->waitForReply<QDBusReply<bool>>(IpcCounters::SetInverseShortcutActions,
+                                                         d->iface()->setInverseShortcutActions(forwardActionId.at(KGlobalAccel::ComponentUnique),
+                                                                                               forwardActionId.at(KGlobalAccel::ActionUnique),
+                                                                                               backwardActionId.at(KGlobalAccel::ActionUnique),
+                                                                                               inverseSetterFlags));
+    return reply.value();
+}
+
+void KGlobalAccel::setAsynchronousUpdates(bool enabled)
+{
+    d->asynchronousUpdates = enabled;
+    if (!enabled && d->batchDepth == 0) {
+        // Send what is still waiting for the event loop
+        d->flushBatch();
+    }
+}
+
+bool KGlobalAccel::asynchronousUpdates() const
+{
+    return d->asynchronousUpdates;
+}
+
+void KGlobalAccel::setPrivateConnection(bool enabled)
+{
+    d->setPrivateConnection(enabled);
+}
+
+bool KGlobalAccel::privateConnection() const
+{
+    return d->privateConnection;
+}
+
+void KGlobalAccel::setCoalesceShortcutChanges(bool enabled)
+{
+    d->coalesceShortcutChanges = enabled;
+    if (!enabled) {
+        // Don't hold back what was queued until now
+        d->flushShortcutChanges();
+    }
+}
+
+bool KGlobalAccel::coalesceShortcutChanges() const
+{
+    return d->coalesceShortcutChanges;
+}
+
+void KGlobalAccel::beginBatch()
+{
+    ++d->batchDepth;
+}
+
+void KGlobalAccel::commitBatch()
+{
+    if (d->batchDepth <= 0) {
+        qCWarning(KGLOBALACCEL_LOG) << "commitBatch() called without matching beginBatch()";
+        return;
+    }
+
+    if (--d->batchDepth == 0) {
+        d->flushBatch();
+    }
 }
 
 QDBusArgument &operator<<(QDBusArgument &argument, const KGlobalAccel::MatchType &type)
@@ -740,3 +1999,4 @@ const QDBusArgument &operator>>(const QDBusArgument &argument, KGlobalAccel::Mat
 }
 
 #include "moc_kglobalaccel.cpp"
+#include "moc_kglobalaccel_p.cpp"
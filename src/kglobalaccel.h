@@ -13,12 +13,12 @@
 #include "kglobalshortcutinfo.h"
 #include <kglobalaccel_export.h>
 
+#include <QFuture>
 #include <QKeySequence>
 #include <QList>
 #include <QObject>
 
 class QAction;
-class OrgKdeKglobalaccelComponentInterface;
 
 /*!
  * \class KGlobalAccel
@@ -174,6 +174,44 @@ public:
      */
     static bool isGlobalShortcutAvailable(const QKeySequence &seq, const QString &component = QString());
 
+    /*!
+     * Asynchronous variant of cleanComponent().
+     *
+     * The returned future finishes with the result once the global shortcuts daemon answered,
+     * \c false if it could not be reached. Cancelling the future discards the answer.
+     *
+     * \since 6.30
+     */
+    static QFuture<bool> cleanComponentAsync(const QString &componentUnique);
+
+    /*!
+     * Asynchronous variant of isComponentActive().
+     *
+     * \sa cleanComponentAsync()
+     * \since 6.30
+     */
+    static QFuture<bool> isComponentActiveAsync(const QString &componentName);
+
+    /*!
+     * Asynchronous variant of globalShortcutsByKey().
+     *
+     * Any number of queries can be in flight at the same time, e.g. to check a key sequence
+     * while the user is still typing it. Cancel the futures of queries that are no longer of
+     * interest, their results are then discarded.
+     *
+     * \sa cleanComponentAsync()
+     * \since 6.30
+     */
+    static QFuture<QList<KGlobalShortcutInfo>> globalShortcutsByKeyAsync(const QKeySequence &seq, MatchType type = Equal);
+
+    /*!
+     * Asynchronous variant of isGlobalShortcutAvailable().
+     *
+     * \sa globalShortcutsByKeyAsync()
+     * \since 6.30
+     */
+    static QFuture<bool> isGlobalShortcutAvailableAsync(const QKeySequence &seq, const QString &component = QString());
+
     /*!
      * Show a messagebox to inform the user that a global shortcut is already occupied,
      * and ask to take it away from its current action(s). This is GUI only, so nothing will
@@ -195,6 +233,8 @@ public:
      *
      * Upon shortcut change the globalShortcutChanged() will be triggered so other applications get notified.
      *
+     * If \a action already has \a shortcut as its default shortcut, nothing is sent to the daemon.
+     *
      * Returns \c true if the shortcut has been set successfully; otherwise returns \c false.
      *
      * \sa globalShortcutChanged()
@@ -239,6 +279,15 @@ public:
      * if you have another very good reason. Key combinations that clash with other shortcuts will be
      * dropped.
      *
+     * If \a action already has \a shortcut, nothing is sent to the daemon. It is therefore cheap to
+     * call this method whenever the action changed.
+     *
+     * If the daemon isn't running on first use, it is started in the background. Until it is
+     * running, shortcuts are queued and sent together once it is, as if they had been set between
+     * beginBatch() and commitBatch(), so this method doesn't wait for the daemon to start up. In
+     * that case shortcut() returns \a shortcut until the daemon has answered. If the daemon is
+     * running already, this method waits for it as usual.
+     *
      * \note the default shortcut will never be influenced by autoloading - it will be set as given.
      * \sa shortcut(), globalShortcutChanged()
      * \since 5.0
@@ -289,6 +338,124 @@ public:
      */
     static bool setInverseShortcutActions(QAction *forwardAction, QAction *backwardAction);
 
+    /*!
+     * Sets whether shortcut changes are sent to the global shortcut daemon without waiting
+     * for its answer.
+     *
+     * By default setShortcut(), setGlobalShortcut() and commitBatch() block until the daemon
+     * has replied with the shortcut it actually assigned, which may differ from the requested
+     * one because of clashes. If \a enabled is \c true these calls return immediately instead.
+     * Until the daemon has answered, shortcut() returns the requested shortcut. If the daemon
+     * assigned a different one, it replaces the requested shortcut and globalShortcutChanged()
+     * is emitted once the answer arrives.
+     *
+     * Outside of a batch, changes are queued until control returns to the event loop and are then
+     * sent together, as if they had been made between beginBatch() and commitBatch(). Changing
+     * the shortcut of an action several times in a row only sends the last one. Turning
+     * asynchronous updates off sends the queued changes right away.
+     *
+     * \sa asynchronousUpdates()
+     * \since 6.30
+     */
+    void setAsynchronousUpdates(bool enabled);
+
+    /*!
+     * Returns \c true if shortcut changes are sent without waiting for the daemon's answer.
+     *
+     * \sa setAsynchronousUpdates()
+     * \since 6.30
+     */
+    bool asynchronousUpdates() const;
+
+    /*!
+     * Sets whether the global shortcut daemon is talked to over a D-Bus connection of its own.
+     *
+     * By default the application's session bus connection is used, which the daemon's messages
+     * share with all other D-Bus traffic of the application. If \a enabled is \c true, a private
+     * connection to the session bus is opened instead. The shortcut signals of the daemon are
+     * received and demarshalled in a worker thread. Only triggering the actions and emitting the
+     * signals of this class happens in the thread of this object, queued from the worker thread.
+     *
+     * Only the delivery of signals moves to the worker thread. Calls to the daemon are still made
+     * from the thread of this object, and those that wait for its answer still block that thread,
+     * e.g. setShortcut() and commitBatch() without asynchronous updates, or globalShortcutsByKey().
+     * The replies to calls that don't wait are still received and demarshalled in that thread too,
+     * i.e. those of shortcut changes with setAsynchronousUpdates(), of the variants returning a
+     * QFuture and of KGlobalShortcutInfoStream.
+     *
+     * On the private connection these calls don't queue behind the application's other D-Bus
+     * traffic anymore, but they cost the thread of this object as much as before. The option keeps
+     * shortcuts responsive in applications with a busy session bus connection, it doesn't make
+     * enumerating or registering shortcuts any cheaper.
+     *
+     * The connection is switched right away, shortcuts pressed while doing so may be missed.
+     *
+     * \sa privateConnection()
+     * \since 6.30
+     */
+    void setPrivateConnection(bool enabled);
+
+    /*!
+     * Returns \c true if the daemon is talked to over a private D-Bus connection.
+     *
+     * \sa setPrivateConnection()
+     * \since 6.30
+     */
+    bool privateConnection() const;
+
+    /*!
+     * Whether changes to shortcuts announced by the global shortcut daemon are announced
+     * one by one.
+     *
+     * When the user applies a whole shortcut scheme the daemon sends one change after the
+     * other. By default each of them is applied and announced with globalShortcutChanged()
+     * as soon as it arrives. If \a enabled is \c true the changes that arrive within one
+     * iteration of the event loop are announced together instead: globalShortcutChanged() is
+     * emitted once per changed action with its final shortcut, followed by a single
+     * globalShortcutsChanged() for all of them. shortcut() returns the new shortcut right away
+     * in both cases.
+     *
+     * \sa coalesceShortcutChanges(), globalShortcutsChanged()
+     * \since 6.30
+     */
+    void setCoalesceShortcutChanges(bool enabled);
+
+    /*!
+     * Returns \c true if shortcut changes announced by the daemon are coalesced.
+     *
+     * \sa setCoalesceShortcutChanges()
+     * \since 6.30
+     */
+    bool coalesceShortcutChanges() const;
+
+    /*!
+     * Starts collecting shortcut registrations instead of sending each of them to the
+     * global shortcut daemon right away.
+     *
+     * All calls to setShortcut(), setDefaultShortcut() and setGlobalShortcut() made until the
+     * matching commitBatch() are queued and sent to the daemon together when commitBatch()
+     * is called. Use this when registering many actions at once, for example at application
+     * startup, to avoid one D-Bus round-trip per action.
+     *
+     * Calls may be nested. Only the outermost commitBatch() sends the queued registrations.
+     *
+     * While a batch is open shortcut() returns the shortcut that was requested. If the daemon
+     * assigns a different shortcut, for example because of a clash, this is applied and
+     * announced with globalShortcutChanged() during commitBatch().
+     *
+     * \sa commitBatch()
+     * \since 6.30
+     */
+    void beginBatch();
+
+    /*!
+     * Sends all shortcut registrations queued since the matching beginBatch() to the daemon.
+     *
+     * \sa beginBatch()
+     * \since 6.30
+     */
+    void commitBatch();
+
     /*!
      * Get the global default shortcut for this \a action, if one exists. Global shortcuts
      * allow your actions to respond to accellerators independently of the focused window.
@@ -319,6 +486,12 @@ public:
      * Retrieves the shortcut as defined in global settings by
      * \a componentName (e.g. "kwin") and \a actionId (e.g. "Kill Window").
      *
+     * Since 6.30 the result is cached, only the first call for a shortcut asks the global
+     * shortcuts daemon. The cache follows changes the daemon announces, i.e. changes made in the
+     * shortcuts settings or through this class. A shortcut that another application changes with
+     * setShortcut() and NoAutoloading is not announced and may be returned with its old keys until
+     * the daemon restarts.
+     *
      * \since 5.10
      */
     QList<QKeySequence> globalShortcut(const QString &componentName, const QString &actionId) const;
@@ -350,6 +523,18 @@ Q_SIGNALS:
      * \since 5.0
      */
     void globalShortcutChanged(QAction *action, const QKeySequence &seq);
+    /*!
+     * Emitted after globalShortcutChanged() was emitted for the \a actions whose shortcuts the
+     * global shortcut daemon changed.
+     *
+     * Without setCoalesceShortcutChanges() \a actions contains the single action of the
+     * preceding globalShortcutChanged(), otherwise all actions that changed within one
+     * iteration of the event loop. Connect to this signal to update a user interface once for
+     * all changes.
+     *
+     * \since 6.30
+     */
+    void globalShortcutsChanged(const QList<QAction *> &actions);
     /*!
      * Emitted when a global shortcut for the given \a action is activated or deactivated.
      *
@@ -359,16 +544,33 @@ Q_SIGNALS:
      * \since 5.94
      */
     void globalShortcutActiveChanged(QAction *action, bool active);
+    /*!
+     * Emitted when all global shortcuts of this application have been registered again after
+     * the global shortcuts daemon was (re)started.
+     *
+     * Recovery runs asynchronously, one call per component, and is delayed by a small random
+     * amount so that not every application talks to the new daemon at the same time. Until this
+     * signal is emitted shortcut() may still return the keys from before the restart.
+     *
+     * Components that the daemon refuses are retried a few times with increasing delays. The
+     * signal is emitted once every component was either restored or given up on, so it also
+     * marks the end of a recovery that failed in parts. Failures are logged as warnings, the
+     * affected shortcuts are sent again with their next change or the next restart.
+     *
+     * \since 6.30
+     */
+    void globalShortcutsRestored();
 
 private:
     KGLOBALACCEL_NO_EXPORT KGlobalAccel();
     KGLOBALACCEL_NO_EXPORT ~KGlobalAccel() override;
 
-    KGLOBALACCEL_NO_EXPORT OrgKdeKglobalaccelComponentInterface *getComponent(const QString &componentUnique);
-
     class KGlobalAccelPrivate *const d;
 
     friend class KGlobalAccelSingleton;
+    friend class KGlobalShortcutInfoStreamPrivate;
+    friend class KGlobalShortcutLatencyStatsPrivate;
+    friend class KGlobalAccelIpcStatsPrivate;
 };
 
 KGLOBALACCEL_EXPORT QDBusArgument &operator<<(QDBusArgument &argument, const KGlobalAccel::MatchType &type);
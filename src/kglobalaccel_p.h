@@ -11,14 +11,24 @@
 #define KGLOBALACCEL_P_H
 
 #include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
 #include <QHash>
 #include <QKeySequence>
 #include <QList>
+#include <QPointer>
+#include <QPromise>
 #include <QStringList>
+#include <QTimer>
+
+#include <chrono>
+#include <memory>
 
 #include "kglobalaccel.h"
 #include "kglobalaccel_component_interface.h"
+#include "ipccounters_p.h"
 #include "kglobalaccel_interface.h"
+#include "shortcutlatencyrecorder_p.h"
 
 enum SetShortcutFlag {
     SetPresent = 2,
@@ -26,6 +36,39 @@ enum SetShortcutFlag {
     IsDefault = 8,
 };
 
+class KGlobalAccelPrivate;
+class QThread;
+
+/// Receives the shortcut signals of all components of kglobalaccel through a single match rule
+/// and hands them to KGlobalAccelPrivate, which looks the actions up in its dispatchIndex
+class KGlobalAccelDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KGlobalAccelDispatcher(KGlobalAccelPrivate *d);
+
+public Q_SLOTS:
+    // Called in the worker thread with a private connection, see KGlobalAccel::setPrivateConnection()
+    void componentSignal(const QString &componentUnique, const QString &shortcutUnique, qlonglong timestamp, const QDBusMessage &message);
+    void yourShortcutsChanged(const QStringList &actionId, const QList<QKeySequence> &newKeys);
+
+private:
+    KGlobalAccelPrivate *const d;
+};
+
+/// Tells KGlobalAccelPrivate when a dynamic property an action id is built from changed
+class KGlobalAccelActionObserver : public QObject
+{
+public:
+    KGlobalAccelActionObserver(KGlobalAccelPrivate *d, QObject *parent);
+
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    KGlobalAccelPrivate *const d;
+};
+
 class KGlobalAccelPrivate
 {
 public:
@@ -50,11 +93,13 @@ public:
     KGlobalAccelPrivate(KGlobalAccel *);
 
     /// Propagate any shortcut changes to the KDED module that does the bookkeeping
-    /// and the key grabbing.
+    /// and the key grabbing. Queued while a batch is open or with asynchronous updates.
     ///@todo KF6
     void updateGlobalShortcut(/*const would be better*/ QAction *action,
                               KGlobalAccelPrivate::ShortcutTypes actionFlags,
                               KGlobalAccel::GlobalShortcutLoading globalFlags);
+    /// Send the shortcut of @p action to kglobalaccel right away, one call per shortcut type
+    void sendGlobalShortcut(QAction *action, KGlobalAccelPrivate::ShortcutTypes actionFlags, KGlobalAccel::GlobalShortcutLoading globalFlags);
 
     /// Register the action in this class and in the KDED module
     bool doRegister(QAction *action); //"register" is a C keyword :p
@@ -73,40 +118,282 @@ public:
     // private slot implementations
     QAction *findAction(const QString &, const QString &);
     void invokeAction(const QString &, const QString &, qlonglong, ShortcutState wasHeld);
-    void invokeDeactivate(const QString &, const QString &);
+    void invokeDeactivate(const QString &, const QString &, qlonglong);
     void shortcutGotChanged(const QStringList &, const QList<int> &);
     void shortcutsChanged(const QStringList &, const QList<QKeySequence> &);
     void serviceOwnerChanged(const QString &name, const QString &oldOwner, const QString &newOwner);
     void reRegisterAll();
 
-    // for all actions with (isEnabled() && globalShortcutAllowed())
-    QMultiHash<QString, QAction *> nameToAction;
-    QSet<QAction *> actions;
+    /// Identifies an action the way kglobalaccel's shortcut signals do
+    struct DispatchKey {
+        QString componentUnique;
+        QString actionUnique;
+
+        friend bool operator==(const DispatchKey &lhs, const DispatchKey &rhs) = default;
+        friend size_t qHash(const DispatchKey &key, size_t seed = 0)
+        {
+            return qHashMulti(seed, key.componentUnique, key.actionUnique);
+        }
+    };
+
+    /// Everything we keep about a registered action
+    struct ActionRecord {
+        QAction *action;
+        //! Cached, only valid if not actionIdStale, see KGlobalAccelPrivate::actionId()
+        QStringList actionId;
+        //! The id last registered with kglobalaccel, it only takes friendly names from registrations
+        QStringList sentActionId;
+        QList<QKeySequence> activeKeys;
+        QList<QKeySequence> defaultKeys;
+        bool hasActiveKeys = false;
+        bool hasDefaultKeys = false;
+        bool actionIdStale = false;
+        //! kglobalaccel was told about the action, until then it is only queued
+        bool sent = false;
+        //! See nextUpdateSerial()
+        quint64 updateSerial = 0;
+        //! Orders the registrations of actions, see updateDispatchEntry()
+        quint64 registration = 0;
+        //! Where the action is in dispatchIndex
+        DispatchKey dispatchKey;
+    };
+    //! All registered actions in no particular order, removing one moves the last record into its place
+    QList<ActionRecord> actionRecords;
+    //! Position of each registered action in actionRecords
+    QHash<const QAction *, qsizetype> actionIndex;
+
+    /// The record of @p action, nullptr if it isn't registered. Only valid until actions are
+    /// registered or removed.
+    ActionRecord *record(const QAction *action);
+    const ActionRecord *record(const QAction *action) const;
+    bool isRegistered(const QAction *action) const
+    {
+        return actionIndex.contains(action);
+    }
+    void eraseRecord(const QAction *action);
+
+    /// The id of the action of @p record, only rebuilt if the action or the application changed
+    const QStringList &actionId(ActionRecord *record);
+    /// Rebuild the id of @p action, of all actions if nullptr, and tell kglobalaccel about
+    /// changed friendly names once control returns to the event loop
+    void invalidateActionId(const QAction *action);
+    void pushChangedFriendlyNames();
+
+    /// Whether kglobalaccel already got @p keys as the keys of all @p types of the action of
+    /// @p record, setting them again would not change anything
+    bool hasKeys(ActionRecord *record, ShortcutTypes types, const QList<QKeySequence> &keys);
 
+    /// What findAction() needs to know about an action, kept up to date so that no QVariant
+    /// property lookups are needed when a shortcut is pressed
+    struct DispatchEntry {
+        QAction *action;
+        quint64 registration;
+        bool enabled;
+        bool isConfigurationAction;
+    };
+    //! Registered actions by component and action name, used to dispatch shortcut signals.
+    //! Several actions may have the same names, they are kept in the order of their registration.
+    QHash<DispatchKey, QList<DispatchEntry>> dispatchIndex;
+    //! Counts registrations for ActionRecord::registration
+    quint64 registrationCount = 0;
+    /// Index @p action under @p actionId, or refresh its entry if it already is
+    void updateDispatchEntry(QAction *action, const QStringList &actionId);
+    void removeDispatchEntry(const ActionRecord *record);
+    /// The entry of @p action in dispatchIndex, nullptr if it has none
+    DispatchEntry *dispatchEntry(const QAction *action);
+
+    //! Measures invokeAction() and invokeDeactivate() if enabled, see KGlobalShortcutLatencyStats
+    ShortcutLatencyRecorder latency;
+
+    //! Keys returned by KGlobalAccel::globalShortcut(), filled on first use. Kept current by
+    //! yourShortcutsChanged and our own calls, dropped when kglobalaccel restarts.
+    QHash<DispatchKey, QList<QKeySequence>> shortcutKeysCache;
+
+    /// The interface of kglobalaccel, created on first use which also starts watching and
+    /// activating kglobalaccel
     org::kde::KGlobalAccel *iface();
+    /// Start kglobalaccel without waiting for it if it isn't running yet
+    void activateService();
+    /// Talk to kglobalaccel over the connection selected by @p privateConnection from now on
+    void setPrivateConnection(bool privateConnection);
+    /// kglobalaccel is there, stop queueing for it and send what was queued in one batch
+    void finishActivation();
+    /// Send what is still queued and wait for it, for when the application exits
+    void flushBeforeExit();
+    /// A blocking call waits for kglobalaccel anyway, send what was queued for its activation
+    /// first so that the reply takes it into account
+    void prepareBlockingCall();
+    /// Whether registrations and updates can be sent, starts activating kglobalaccel if needed
+    bool isServiceActive();
+
+    enum ServiceState {
+        ServiceInactive, ///< Nobody asked for kglobalaccel yet
+        ServiceActivating, ///< Waiting for kglobalaccel to start, registrations and updates are queued
+        ServiceActive,
+    };
+    ServiceState serviceState = ServiceInactive;
+    //! kglobalaccel went away or couldn't be started, its next owner has to be told everything
+    bool serviceLost = false;
+    QDBusConnection bus() const
+    {
+        return m_bus;
+    }
 
-    //! Get the component @p componentUnique. If @p remember is true the instance is cached and we
-    //! subscribe to signals about changes to the component.
-    org::kde::kglobalaccel::Component *getComponent(const QString &componentUnique, bool remember);
+    //! The D-Bus path of the component @p componentUnique, empty if it doesn't exist. Asks
+    //! kglobalaccel on first use, the path is kept until the component was idle for a while.
+    QString componentPath(const QString &componentUnique);
+    void rememberComponentPath(const QString &componentUnique, const QString &path);
+    void evictIdleComponents();
+    //! Call the boolean @p method of the component @p componentUnique, false if the component
+    //! doesn't exist
+    bool callComponent(const QString &componentUnique, IpcCounters::Method method);
+
+    /// Returns a future that gets the result of @p handler once @p call finished. The handler
+    /// is not called if the future was cancelled in the meantime.
+    template<typename T, typename Handler>
+    QFuture<T> futureForCall(const QDBusPendingCall &call, Handler handler)
+    {
+        auto promise = std::make_shared<QPromise<T>>();
+        promise->start();
+        auto watcher = new QDBusPendingCallWatcher(call, q);
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished, q, [promise, handler](QDBusPendingCallWatcher *watcher) {
+            watcher->deleteLater();
+            if (!promise->isCanceled()) {
+                promise->addResult(handler(*watcher));
+            }
+            promise->finish();
+        });
+        return promise->future();
+    }
+
+    /// Waits for the reply to @p call of @p method, the time spent waiting counts as blocked
+    template<typename Reply>
+    Reply waitForReply(IpcCounters::Method method, const QDBusPendingCall &call)
+    {
+        const auto blocked = ipcCounters.blocking(method);
+        return Reply(call);
+    }
+
+    //! Calls and signals exchanged with kglobalaccel, see KGlobalAccelIpcStats
+    IpcCounters ipcCounters;
+
+    //! Call the boolean @p method of the component @p componentUnique without blocking, false
+    //! if the component doesn't exist
+    QFuture<bool> callComponentAsync(const QString &componentUnique, IpcCounters::Method method);
 
     //! Our owner
     KGlobalAccel *q;
 
-    //! The components the application is using
-    QHash<QString, org::kde::kglobalaccel::Component *> components;
-    QMap<const QAction *, QList<QKeySequence>> actionDefaultShortcuts;
-    QMap<const QAction *, QList<QKeySequence>> actionShortcuts;
+    /// A component of kglobalaccel we talked to
+    struct ComponentEntry {
+        QString path;
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+    //! The components the application is using or asked about
+    QHash<QString, ComponentEntry> components;
+    //! Number of registered actions per component, their paths are never evicted
+    QHash<QString, int> componentActionCounts;
 
     bool setShortcutWithDefault(QAction *action, const QList<QKeySequence> &shortcut, KGlobalAccel::GlobalShortcutLoading loadFlag);
 
+    //! Drops an action from the count of @p componentUnique
+    void releaseComponent(const QString &componentUnique);
+    //! Records that kglobalaccel knows the action of @p record as @p actionId
+    void markSent(ActionRecord *record, const QStringList &actionId);
     void unregister(const QStringList &actionId);
     void setInactive(const QStringList &actionId);
 
+    /// Apply the active keys kglobalaccel returned for a shortcut we sent it
+    void applyActiveShortcutResult(QAction *action,
+                                   const QStringList &actionId,
+                                   const QList<QKeySequence> &sentKeys,
+                                   const QList<QKeySequence> &resultKeys,
+                                   bool isConfigurationAction,
+                                   KGlobalAccel::GlobalShortcutLoading globalFlags);
+
+    struct PendingUpdate {
+        QPointer<QAction> action;
+        ShortcutTypes actionFlags;
+        KGlobalAccel::GlobalShortcutLoading globalFlags;
+    };
+
+    /// One element of a setShortcutKeysBatch call
+    struct BatchEntry {
+        QPointer<QAction> action; ///< null for default keys, there is nothing to apply for them
+        QStringList actionId;
+        QList<QKeySequence> keys;
+        bool isConfigurationAction;
+        KGlobalAccel::GlobalShortcutLoading globalFlags;
+        quint64 serial;
+    };
+
+    /// Send everything queued while a batch was open, see KGlobalAccel::beginBatch()
+    void flushBatch();
+    void finishBatch(const QDBusPendingCall &call,
+                     const QList<BatchEntry> &entries,
+                     const QList<QPointer<QAction>> &registrations,
+                     const QList<PendingUpdate> &updates);
+
+    /// Replies to asynchronous updates are only applied if no newer update was sent for the action
+    quint64 nextUpdateSerial(const QAction *action);
+    bool isCurrentUpdate(const QAction *action, quint64 serial) const;
+
+    /// Flush the queued registrations and updates once control returns to the event loop,
+    /// used for asynchronous updates outside of a batch
+    void scheduleFlush();
+
+    int batchDepth = 0;
+    QList<QPointer<QAction>> pendingRegistrations;
+    QList<PendingUpdate> pendingUpdates;
+    //! Set when kglobalaccel doesn't know setShortcutKeysBatch, we fall back to one call per action then
+    bool batchUnsupported = false;
+    //! Set when kglobalaccel doesn't know the methods returning KGlobalShortcutInfoTable, we
+    //! fall back to the methods returning a list of infos then
+    bool infoTablesUnsupported = false;
+
+    bool asynchronousUpdates = false;
+    //! See KGlobalAccel::setPrivateConnection()
+    bool privateConnection = false;
+
+    /// Announce the new active keys of the registered @p action, queued in coalescing mode
+    void announceShortcutChange(QAction *action);
+    /// Announce the changes queued by announceShortcutChange() in coalescing mode
+    void flushShortcutChanges();
+    bool coalesceShortcutChanges = false;
+    //! Actions changed by kglobalaccel that were not announced yet, in the order of the changes
+    QList<QPointer<QAction>> changedActions;
+    quint64 lastUpdateSerial = 0;
+
+    /// Send the shortcuts of one component to a restarted kglobalaccel, see reRegisterAll()
+    void restoreComponent(quint64 generation, const QString &componentUnique, const QList<QPointer<QAction>> &componentActions, int attempt);
+    void restoreComponentFinished(const QDBusPendingCall &call,
+                                  quint64 generation,
+                                  const QString &componentUnique,
+                                  const QList<QPointer<QAction>> &componentActions,
+                                  int attempt,
+                                  const QList<BatchEntry> &entries);
+    /// The same for a kglobalaccel without setShortcutKeysBatch
+    void restoreComponentOneByOne(quint64 generation, const QList<QPointer<QAction>> &componentActions);
+    void finishRestore(quint64 generation);
+
+    //! Counts kglobalaccel restarts, replies belonging to an older restart are ignored
+    quint64 restoreGeneration = 0;
+    //! Components still being restored for the current restoreGeneration
+    int pendingRestores = 0;
+
 private:
     QDBusConnection m_bus;
     org::kde::KGlobalAccel *m_iface = nullptr;
     QPointer<QAction> m_lastActivatedAction;
-    QDBusServiceWatcher *m_watcher;
+    QDBusServiceWatcher *m_watcher = nullptr;
+    QTimer *m_componentEvictionTimer = nullptr;
+    QTimer *m_changeNotificationTimer = nullptr;
+    KGlobalAccelDispatcher *m_dispatcher = nullptr;
+    //! Runs m_dispatcher with a private connection
+    QThread *m_workerThread = nullptr;
+    KGlobalAccelActionObserver *m_actionObserver = nullptr;
+    QTimer *m_actionIdTimer = nullptr;
+    QTimer *m_flushTimer = nullptr;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(KGlobalAccelPrivate::ShortcutTypes)
@@ -0,0 +1,135 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kglobalaccelipcstats.h"
+#include "ipccounters_p.h"
+#include "kglobalaccel_p.h"
+
+namespace
+{
+qint64 toMicroseconds(IpcCounters::Clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+}
+
+class KGlobalAccelIpcStatsPrivate
+{
+public:
+    IpcCounters *counters() const
+    {
+        return &KGlobalAccel::self()->d->ipcCounters;
+    }
+};
+
+KGlobalAccelIpcStats::KGlobalAccelIpcStats(QObject *parent)
+    : QObject(parent)
+    , d(new KGlobalAccelIpcStatsPrivate)
+{
+    d->counters()->addUser();
+}
+
+KGlobalAccelIpcStats::~KGlobalAccelIpcStats()
+{
+    d->counters()->removeUser();
+}
+
+QStringList KGlobalAccelIpcStats::methods() const
+{
+    QStringList methods;
+    for (int method = 0; method < IpcCounters::MethodCount; ++method) {
+        const IpcCounters::MethodCounters &counters = d->counters()->counters(IpcCounters::Method(method));
+        if (counters.calls > 0 || counters.blocked > IpcCounters::Clock::duration(0)) {
+            methods.append(IpcCounters::MethodNames[method]);
+        }
+    }
+    return methods;
+}
+
+int KGlobalAccelIpcStats::callCount(const QString &method) const
+{
+    return d->counters()->counters(method).calls;
+}
+
+qint64 KGlobalAccelIpcStats::bytesSent(const QString &method) const
+{
+    return d->counters()->counters(method).bytes;
+}
+
+std::chrono::nanoseconds KGlobalAccelIpcStats::blockedTime(const QString &method) const
+{
+    return d->counters()->counters(method).blocked;
+}
+
+int KGlobalAccelIpcStats::totalCallCount() const
+{
+    int calls = 0;
+    for (int method = 0; method < IpcCounters::MethodCount; ++method) {
+        calls += d->counters()->counters(IpcCounters::Method(method)).calls;
+    }
+    return calls;
+}
+
+qint64 KGlobalAccelIpcStats::totalBytesSent() const
+{
+    qint64 bytes = 0;
+    for (int method = 0; method < IpcCounters::MethodCount; ++method) {
+        bytes += d->counters()->counters(IpcCounters::Method(method)).bytes;
+    }
+    return bytes;
+}
+
+std::chrono::nanoseconds KGlobalAccelIpcStats::totalBlockedTime() const
+{
+    IpcCounters::Clock::duration blocked{0};
+    for (int method = 0; method < IpcCounters::MethodCount; ++method) {
+        blocked += d->counters()->counters(IpcCounters::Method(method)).blocked;
+    }
+    return blocked;
+}
+
+int KGlobalAccelIpcStats::signalsReceived() const
+{
+    return d->counters()->signalsReceived();
+}
+
+int KGlobalAccelIpcStats::restartsHandled() const
+{
+    return d->counters()->restartsHandled();
+}
+
+void KGlobalAccelIpcStats::reset()
+{
+    d->counters()->reset();
+}
+
+bool KGlobalAccelIpcStats::exportOnBus(QDBusConnection connection, const QString &path)
+{
+    return connection.registerObject(path, this, QDBusConnection::ExportScriptableSlots);
+}
+
+QVariantMap KGlobalAccelIpcStats::snapshot() const
+{
+    QVariantMap snapshot;
+    const QStringList methods = this->methods();
+    for (const QString &method : methods) {
+        const IpcCounters::MethodCounters counters = d->counters()->counters(method);
+        snapshot.insert(method,
+                        QVariantMap{
+                            {QStringLiteral("calls"), counters.calls},
+                            {QStringLiteral("bytes"), counters.bytes},
+                            {QStringLiteral("blockedUs"), toMicroseconds(counters.blocked)},
+                        });
+    }
+    snapshot.insert(QStringLiteral("totalCalls"), totalCallCount());
+    snapshot.insert(QStringLiteral("totalBytes"), totalBytesSent());
+    snapshot.insert(QStringLiteral("totalBlockedUs"), toMicroseconds(totalBlockedTime()));
+    snapshot.insert(QStringLiteral("signalsReceived"), signalsReceived());
+    snapshot.insert(QStringLiteral("restartsHandled"), restartsHandled());
+    return snapshot;
+}
+
+#include "moc_kglobalaccelipcstats.cpp"
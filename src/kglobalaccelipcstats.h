@@ -0,0 +1,131 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KGLOBALACCELIPCSTATS_H
+#define KGLOBALACCELIPCSTATS_H
+
+#include <kglobalaccel_export.h>
+
+#include <QDBusConnection>
+#include <QObject>
+#include <QStringList>
+#include <QVariantMap>
+
+#include <chrono>
+#include <memory>
+
+class KGlobalAccelIpcStatsPrivate;
+
+/*!
+ * \class KGlobalAccelIpcStats
+ * \inmodule KGlobalAccel
+ * \brief Shows how much the application talks to the global shortcuts daemon.
+ *
+ * KGlobalAccel counts every D-Bus call it makes to the daemon, estimates the size of the
+ * arguments it sends and measures how long the application was blocked waiting for replies.
+ * It also counts the shortcut signals it received and how often the daemon was restarted.
+ * Counting starts with the first use of KGlobalAccel, so the counters include the calls made
+ * during application startup. Estimating the size of the arguments is more expensive, bytes are
+ * only counted while a stats object exists.
+ *
+ * \code
+ * KGlobalAccelIpcStats stats;
+ * qDebug() << stats.totalCallCount() << "calls, blocked for" << stats.totalBlockedTime();
+ * \endcode
+ *
+ * With exportOnBus() the counters can be read from outside the application:
+ *
+ * \code
+ * qdbus org.kde.myapp /KGlobalAccelIpcStats org.kde.kglobalaccel.IpcStats.snapshot
+ * \endcode
+ *
+ * All stats objects show the same counters. They must be used on the main thread.
+ *
+ * \since 6.30
+ */
+class KGLOBALACCEL_EXPORT KGlobalAccelIpcStats : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kglobalaccel.IpcStats")
+
+public:
+    /*!
+     * Constructs a stats object with the given \a parent.
+     */
+    explicit KGlobalAccelIpcStats(QObject *parent = nullptr);
+    ~KGlobalAccelIpcStats() override;
+
+    /*!
+     * Returns the D-Bus methods that were called, e.g. "setShortcutKeys".
+     */
+    QStringList methods() const;
+
+    /*!
+     * Returns how often \a method was called.
+     */
+    int callCount(const QString &method) const;
+
+    /*!
+     * Returns the estimated number of bytes sent as arguments of \a method while a stats object
+     * existed.
+     */
+    qint64 bytesSent(const QString &method) const;
+
+    /*!
+     * Returns how long the application was blocked waiting for replies to \a method.
+     */
+    std::chrono::nanoseconds blockedTime(const QString &method) const;
+
+    /*!
+     * Returns the number of calls of all methods.
+     */
+    int totalCallCount() const;
+
+    /*!
+     * Returns the estimated number of bytes sent as arguments of all methods.
+     */
+    qint64 totalBytesSent() const;
+
+    /*!
+     * Returns how long the application was blocked waiting for replies to all methods.
+     */
+    std::chrono::nanoseconds totalBlockedTime() const;
+
+    /*!
+     * Returns the number of signals received from the daemon, i.e. shortcut activations and
+     * shortcut changes.
+     */
+    int signalsReceived() const;
+
+    /*!
+     * Returns how often the daemon was restarted and the shortcuts were registered again.
+     */
+    int restartsHandled() const;
+
+    /*!
+     * Sets all counters to zero.
+     */
+    void reset();
+
+    /*!
+     * Makes the counters readable by other processes through the snapshot() method of the
+     * object \a path on \a connection. Returns \c false if the object could not be registered.
+     */
+    bool exportOnBus(QDBusConnection connection = QDBusConnection::sessionBus(), const QString &path = QStringLiteral("/KGlobalAccelIpcStats"));
+
+public Q_SLOTS:
+    /*!
+     * Returns all counters as a map. Each method has an entry with a map of "calls", "bytes"
+     * and "blockedUs", the totals are in "totalCalls", "totalBytes" and "totalBlockedUs", the
+     * remaining counters in "signalsReceived" and "restartsHandled".
+     */
+    Q_SCRIPTABLE QVariantMap snapshot() const;
+
+private:
+    std::unique_ptr<KGlobalAccelIpcStatsPrivate> const d;
+};
+
+#endif
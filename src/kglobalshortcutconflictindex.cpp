@@ -0,0 +1,214 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kglobalshortcutconflictindex.h"
+#include "packedkeysequence_p.h"
+
+#include <QHash>
+#include <QSet>
+
+#include <vector>
+
+/*
+ * A trie over every suffix of every key sequence in the index. Each node stands for a
+ * contiguous part of at least one key sequence, i.e. its path from the root. It knows which
+ * shortcuts have a sequence that is exactly this path, and which have one the path is a proper
+ * part of. That answers Equal and Shadows with a single walk; for Shadowed the parts of the
+ * query are walked instead.
+ *
+ * Shortcuts are reference counted per node since a shortcut can reach a node several times,
+ * through several sequences or a sequence repeating keys. Nodes are not freed when shortcuts are
+ * removed, the number of distinct key sequences in use is small.
+ */
+class KGlobalShortcutConflictIndexPrivate
+{
+public:
+    struct Node {
+        QHash<int, int> children;
+        QHash<QString, int> sequences;
+        QHash<QString, int> containing;
+    };
+
+    KGlobalShortcutConflictIndexPrivate()
+        : nodes(1)
+    {
+    }
+
+    void addSequence(const QString &id, const PackedKeySequence &keys, int delta);
+    static void addReference(QHash<QString, int> &references, const QString &id, int delta);
+    //! The node for the path @p keys, -1 if there is none
+    int findNode(const PackedKeySequence &keys) const;
+
+    std::vector<Node> nodes;
+    QHash<QString, QList<QKeySequence>> shortcuts;
+};
+
+void KGlobalShortcutConflictIndexPrivate::addReference(QHash<QString, int> &references, const QString &id, int delta)
+{
+    auto it = references.find(id);
+    if (it == references.end()) {
+        references.insert(id, delta);
+    } else if ((*it += delta) == 0) {
+        references.erase(it);
+    }
+}
+
+void KGlobalShortcutConflictIndexPrivate::addSequence(const QString &id, const PackedKeySequence &keys, int delta)
+{
+    const int count = keys.count();
+    for (int start = 0; start < count; ++start) {
+        int node = 0;
+        for (int end = start + 1; end <= count; ++end) {
+            const int key = keys[end - 1];
+            auto child = nodes[node].children.constFind(key);
+            if (child != nodes[node].children.cend()) {
+                node = *child;
+            } else {
+                // Only happens while adding, removed sequences were added before
+                Q_ASSERT(delta > 0);
+                nodes.emplace_back();
+                nodes[node].children.insert(key, int(nodes.size() - 1));
+                node = int(nodes.size() - 1);
+            }
+
+            if (start == 0 && end == count) {
+                addReference(nodes[node].sequences, id, delta);
+            } else {
+                addReference(nodes[node].containing, id, delta);
+            }
+        }
+    }
+}
+
+int KGlobalShortcutConflictIndexPrivate::findNode(const PackedKeySequence &keys) const
+{
+    int node = 0;
+    for (int i = 0; i < keys.count(); ++i) {
+        const auto child = nodes[node].children.constFind(keys[i]);
+        if (child == nodes[node].children.cend()) {
+            return -1;
+        }
+        node = *child;
+    }
+    return node;
+}
+
+KGlobalShortcutConflictIndex::KGlobalShortcutConflictIndex()
+    : d(new KGlobalShortcutConflictIndexPrivate)
+{
+}
+
+KGlobalShortcutConflictIndex::~KGlobalShortcutConflictIndex() = default;
+
+KGlobalShortcutConflictIndex::KGlobalShortcutConflictIndex(KGlobalShortcutConflictIndex &&other) noexcept = default;
+KGlobalShortcutConflictIndex &KGlobalShortcutConflictIndex::operator=(KGlobalShortcutConflictIndex &&other) noexcept = default;
+
+void KGlobalShortcutConflictIndex::insert(const QString &id, const QList<QKeySequence> &keys)
+{
+    remove(id);
+
+    QList<QKeySequence> &stored = d->shortcuts[id];
+    for (const QKeySequence &seq : keys) {
+        if (seq.isEmpty()) {
+            continue;
+        }
+        stored.append(seq);
+        d->addSequence(id, PackedKeySequence(seq).mangled(), 1);
+    }
+}
+
+void KGlobalShortcutConflictIndex::remove(const QString &id)
+{
+    const auto it = d->shortcuts.constFind(id);
+    if (it == d->shortcuts.cend()) {
+        return;
+    }
+    for (const QKeySequence &seq : *it) {
+        d->addSequence(id, PackedKeySequence(seq).mangled(), -1);
+    }
+    d->shortcuts.erase(it);
+}
+
+void KGlobalShortcutConflictIndex::clear()
+{
+    d->nodes.assign(1, KGlobalShortcutConflictIndexPrivate::Node());
+    d->shortcuts.clear();
+}
+
+int KGlobalShortcutConflictIndex::size() const
+{
+    return d->shortcuts.size();
+}
+
+bool KGlobalShortcutConflictIndex::isEmpty() const
+{
+    return d->shortcuts.isEmpty();
+}
+
+bool KGlobalShortcutConflictIndex::contains(const QString &id) const
+{
+    return d->shortcuts.contains(id);
+}
+
+QList<QKeySequence> KGlobalShortcutConflictIndex::keys(const QString &id) const
+{
+    return d->shortcuts.value(id);
+}
+
+QStringList KGlobalShortcutConflictIndex::find(const QKeySequence &seq, KGlobalAccel::MatchType type) const
+{
+    const PackedKeySequence keys = PackedKeySequence(seq).mangled();
+    const int count = keys.count();
+    if (count == 0) {
+        return {};
+    }
+
+    switch (type) {
+    case KGlobalAccel::Equal: {
+        const int node = d->findNode(keys);
+        return node < 0 ? QStringList() : d->nodes[node].sequences.keys();
+    }
+    case KGlobalAccel::Shadows: {
+        // seq is a proper part of the sequences containing it
+        const int node = d->findNode(keys);
+        return node < 0 ? QStringList() : d->nodes[node].containing.keys();
+    }
+    case KGlobalAccel::Shadowed: {
+        // Sequences that are a proper part of seq, walk each part of seq that starts at some key
+        QSet<QString> result;
+        for (int start = 0; start < count; ++start) {
+            int node = 0;
+            for (int end = start + 1; end <= count; ++end) {
+                const auto child = d->nodes[node].children.constFind(keys[end - 1]);
+                if (child == d->nodes[node].children.cend()) {
+                    break;
+                }
+                node = *child;
+                if (start == 0 && end == count) {
+                    // That's seq itself
+                    break;
+                }
+                for (auto it = d->nodes[node].sequences.cbegin(); it != d->nodes[node].sequences.cend(); ++it) {
+                    result.insert(it.key());
+                }
+            }
+        }
+        return QStringList(result.cbegin(), result.cend());
+    }
+    }
+
+    return {};
+}
+
+QStringList KGlobalShortcutConflictIndex::conflicts(const QKeySequence &seq) const
+{
+    QSet<QString> result;
+    for (const auto type : {KGlobalAccel::Equal, KGlobalAccel::Shadows, KGlobalAccel::Shadowed}) {
+        const QStringList ids = find(seq, type);
+        result.unite(QSet<QString>(ids.cbegin(), ids.cend()));
+    }
+    return QStringList(result.cbegin(), result.cend());
+}
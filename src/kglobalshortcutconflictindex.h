@@ -0,0 +1,115 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KGLOBALSHORTCUTCONFLICTINDEX_H
+#define KGLOBALSHORTCUTCONFLICTINDEX_H
+
+#include "kglobalaccel.h"
+#include <kglobalaccel_export.h>
+
+#include <QKeySequence>
+#include <QList>
+#include <QStringList>
+
+#include <memory>
+
+class KGlobalShortcutConflictIndexPrivate;
+
+/*!
+ * \class KGlobalShortcutConflictIndex
+ * \inmodule KGlobalAccel
+ * \brief Finds clashing key sequences among a set of shortcuts without asking the daemon.
+ *
+ * The index holds the keys of any number of shortcuts, each identified by a string chosen by
+ * the caller. find() answers the same questions as KGlobalAccel::globalShortcutsByKey() does
+ * for the shortcuts known to the global shortcuts daemon, in time proportional to the length
+ * of the key sequence rather than to the number of shortcuts. This makes it suitable for
+ * checking many shortcuts at once, e.g. when importing a shortcut scheme.
+ *
+ * \code
+ * KGlobalShortcutConflictIndex index;
+ * for (const KGlobalShortcutInfo &info : infos) {
+ *     index.insert(info.componentUniqueName() + QLatin1Char('/') + info.uniqueName(), info.keys());
+ * }
+ * const QStringList clashes = index.conflicts(QKeySequence(Qt::META | Qt::Key_E));
+ * \endcode
+ *
+ * Like kglobalaccel, the index does not distinguish Shift+Tab from Shift+Backtab.
+ *
+ * \since 6.30
+ */
+class KGLOBALACCEL_EXPORT KGlobalShortcutConflictIndex
+{
+public:
+    /*!
+     * Constructs an empty index.
+     */
+    KGlobalShortcutConflictIndex();
+    ~KGlobalShortcutConflictIndex();
+
+    /*!
+     * Move constructor. \a other can only be assigned to or destroyed afterwards.
+     */
+    KGlobalShortcutConflictIndex(KGlobalShortcutConflictIndex &&other) noexcept;
+    KGlobalShortcutConflictIndex &operator=(KGlobalShortcutConflictIndex &&other) noexcept;
+
+    /*!
+     * Adds the shortcut \a id with the key sequences \a keys, replacing the keys \a id had before.
+     * Empty key sequences are ignored.
+     */
+    void insert(const QString &id, const QList<QKeySequence> &keys);
+
+    /*!
+     * Removes the shortcut \a id from the index.
+     */
+    void remove(const QString &id);
+
+    /*!
+     * Removes all shortcuts from the index.
+     */
+    void clear();
+
+    /*!
+     * Returns the number of shortcuts in the index.
+     */
+    int size() const;
+
+    /*!
+     * Returns \c true if the index contains no shortcuts.
+     */
+    bool isEmpty() const;
+
+    /*!
+     * Returns \c true if the index contains the shortcut \a id.
+     */
+    bool contains(const QString &id) const;
+
+    /*!
+     * Returns the key sequences of the shortcut \a id, as passed to insert().
+     */
+    QList<QKeySequence> keys(const QString &id) const;
+
+    /*!
+     * Returns the shortcuts with a key sequence that relates to \a seq as described by \a type,
+     * in no particular order. An empty \a seq matches nothing.
+     *
+     * \sa KGlobalAccel::MatchType
+     */
+    QStringList find(const QKeySequence &seq, KGlobalAccel::MatchType type = KGlobalAccel::Equal) const;
+
+    /*!
+     * Returns the shortcuts that clash with \a seq in any way, i.e. the union of the results
+     * of find() for all match types, in no particular order.
+     */
+    QStringList conflicts(const QKeySequence &seq) const;
+
+private:
+    std::unique_ptr<KGlobalShortcutConflictIndexPrivate> d;
+
+    Q_DISABLE_COPY(KGlobalShortcutConflictIndex)
+};
+
+#endif
@@ -14,30 +14,27 @@ KGlobalShortcutInfo::KGlobalShortcutInfo()
 
 KGlobalShortcutInfo::KGlobalShortcutInfo(const KGlobalShortcutInfo &rhs)
     : QObject()
-    , d(new KGlobalShortcutInfoPrivate)
+    , d(rhs.d)
 {
-    d->contextUniqueName = rhs.d->contextUniqueName;
-    d->contextFriendlyName = rhs.d->contextFriendlyName;
-    d->componentFriendlyName = rhs.d->componentFriendlyName;
-    d->componentUniqueName = rhs.d->componentUniqueName;
-    d->friendlyName = rhs.d->friendlyName;
-    d->uniqueName = rhs.d->uniqueName;
-    d->keys = rhs.d->keys;
-    d->defaultKeys = rhs.d->defaultKeys;
 }
 
-KGlobalShortcutInfo::~KGlobalShortcutInfo()
+KGlobalShortcutInfo::KGlobalShortcutInfo(KGlobalShortcutInfo &&rhs) noexcept
+    : QObject()
+    , d(std::move(rhs.d))
 {
-    delete d;
 }
 
+KGlobalShortcutInfo::~KGlobalShortcutInfo() = default;
+
 KGlobalShortcutInfo &KGlobalShortcutInfo::operator=(const KGlobalShortcutInfo &rhs)
 {
-    KGlobalShortcutInfo tmp(rhs);
-    KGlobalShortcutInfoPrivate *swap;
-    swap = d;
-    d = tmp.d;
-    tmp.d = swap;
+    d = rhs.d;
+    return *this;
+}
+
+KGlobalShortcutInfo &KGlobalShortcutInfo::operator=(KGlobalShortcutInfo &&rhs) noexcept
+{
+    d.swap(rhs.d);
     return *this;
 }
 
@@ -13,6 +13,7 @@
 #include <QKeySequence>
 #include <QList>
 #include <QObject>
+#include <QSharedDataPointer>
 
 class KGlobalShortcutInfoPrivate;
 
@@ -40,10 +41,13 @@ public:
     /* clang-format on */
 
     KGlobalShortcutInfo(const KGlobalShortcutInfo &rhs);
+    // Only the data is moved, rhs can only be assigned to or destroyed afterwards
+    KGlobalShortcutInfo(KGlobalShortcutInfo &&rhs) noexcept;
 
     ~KGlobalShortcutInfo() override;
 
     KGlobalShortcutInfo &operator=(const KGlobalShortcutInfo &rhs);
+    KGlobalShortcutInfo &operator=(KGlobalShortcutInfo &&rhs) noexcept;
 
     QString contextFriendlyName() const;
 
@@ -63,12 +67,13 @@ public:
 
 private:
     friend class GlobalShortcut;
+    friend class KGlobalShortcutInfoTable;
 
     friend KGLOBALACCEL_EXPORT const QDBusArgument &operator>>(const QDBusArgument &argument, KGlobalShortcutInfo &shortcut);
     friend KGLOBALACCEL_EXPORT const QDBusArgument &operator>>(const QDBusArgument &argument, QKeySequence &sequence);
 
-    //! Implementation details
-    KGlobalShortcutInfoPrivate *d;
+    //! Implementation details, shared between copies until one of them is modified
+    QSharedDataPointer<KGlobalShortcutInfoPrivate> d;
 };
 
 KGLOBALACCEL_EXPORT QDBusArgument &operator<<(QDBusArgument &argument, const KGlobalShortcutInfo &shortcut);
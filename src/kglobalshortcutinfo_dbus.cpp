@@ -5,14 +5,19 @@
 */
 
 #include "kglobalshortcutinfo.h"
+#include "kglobalaccel_debug.h"
 #include "kglobalshortcutinfo_p.h"
+#include "packedkeysequence_p.h"
+
+#include <tuple>
 
 QDBusArgument &operator<<(QDBusArgument &argument, const QKeySequence &sequence)
 {
+    const PackedKeySequence packed(sequence);
     argument.beginStructure();
     argument.beginArray(qMetaTypeId<int>());
     for (int i = 0; i < maxSequenceLength; i++) {
-        argument << (i < sequence.count() ? sequence[i].toCombined() : 0);
+        argument << packed[i];
     }
     argument.endArray();
     argument.endStructure();
@@ -21,16 +26,9 @@ QDBusArgument &operator<<(QDBusArgument &argument, const QKeySequence &sequence)
 
 const QDBusArgument &operator>>(const QDBusArgument &argument, QKeySequence &sequence)
 {
-    int s1;
-    int s2;
-    int s3;
-    int s4;
-    argument.beginStructure();
-    argument.beginArray();
-    argument >> s1 >> s2 >> s3 >> s4;
-    sequence = QKeySequence(s1, s2, s3, s4);
-    argument.endArray();
-    argument.endStructure();
+    PackedKeySequence packed;
+    argument >> packed;
+    sequence = packed.toKeySequence();
     return argument;
 }
 
@@ -75,20 +73,47 @@ const QDBusArgument &operator>>(const QDBusArgument &argument, KGlobalShortcutIn
              >> shortcut.d->contextFriendlyName;
     /* clang-format on */
 
-    argument.beginArray();
-    while (!argument.atEnd()) {
-        int key;
-        argument >> key;
-        shortcut.d->keys.append(QKeySequence(key));
-    }
-    argument.endArray();
-    argument.beginArray();
-    while (!argument.atEnd()) {
-        int key;
-        argument >> key;
-        shortcut.d->defaultKeys.append(QKeySequence(key));
-    }
-    argument.endArray();
+    // This format only has the first key of each sequence
+    const auto toKeySequence = [](int key) {
+        return PackedKeySequence(key).toKeySequence();
+    };
+    shortcut.d->keys = readKeyArray<int>(argument, toKeySequence);
+    shortcut.d->defaultKeys = readKeyArray<int>(argument, toKeySequence);
     argument.endStructure();
     return argument;
 }
+
+namespace
+{
+QList<QKeySequence> toKeySequences(const QList<PackedKeySequence> &packed)
+{
+    QList<QKeySequence> sequences;
+    sequences.reserve(packed.size());
+    for (const PackedKeySequence &sequence : packed) {
+        sequences.append(sequence.toKeySequence());
+    }
+    return sequences;
+}
+}
+
+QList<KGlobalShortcutInfo> KGlobalShortcutInfoTable::infos() const
+{
+    QList<KGlobalShortcutInfo> infos;
+    infos.reserve(entries.size());
+    for (const Entry &entry : entries) {
+        if (entry.component >= uint(components.size()) || entry.context >= uint(contexts.size())) {
+            qCWarning(KGLOBALACCEL_LOG) << "Ignoring shortcut" << entry.uniqueName << "with invalid component or context index";
+            continue;
+        }
+        KGlobalShortcutInfo info;
+        // Assigning the strings of the tables shares their data between all infos
+        std::tie(info.d->componentUniqueName, info.d->componentFriendlyName) = components.at(entry.component);
+        std::tie(info.d->contextUniqueName, info.d->contextFriendlyName) = contexts.at(entry.context);
+        info.d->uniqueName = entry.uniqueName;
+        info.d->friendlyName = entry.friendlyName;
+        info.d->keys = toKeySequences(entry.keys);
+        info.d->defaultKeys = toKeySequences(entry.defaultKeys);
+        infos.append(std::move(info));
+    }
+    return infos;
+}
@@ -15,8 +15,17 @@ static const int maxSequenceLength = 4;
 
 #include "kglobalaccel.h"
 #include "kglobalshortcutinfo.h"
+#include "packedkeysequence_p.h"
 
-class KGlobalShortcutInfoPrivate
+#include <QDBusArgument>
+#include <QList>
+#include <QSharedData>
+
+#include <array>
+#include <type_traits>
+#include <utility>
+
+class KGlobalShortcutInfoPrivate : public QSharedData
 {
 public:
     QString contextUniqueName;
@@ -29,4 +38,94 @@ public:
     QList<QKeySequence> defaultKeys;
 };
 
+/**
+ * @internal
+ *
+ * Reads a D-Bus array of @p T and returns its elements converted by @p convert.
+ *
+ * QDBusArgument doesn't tell the length of an array before it is read. Key lists are short, so
+ * reading into a small buffer first gets the exact size without growing the list step by step.
+ */
+template<typename T, typename Convert>
+auto readKeyArray(const QDBusArgument &argument, Convert convert)
+{
+    std::array<T, 4> buffer{};
+    QList<std::remove_cvref_t<decltype(convert(buffer[0]))>> result;
+    qsizetype buffered = 0;
+    const auto flush = [&] {
+        for (qsizetype i = 0; i < buffered; ++i) {
+            result.append(convert(buffer[i]));
+        }
+        buffered = 0;
+    };
+    argument.beginArray();
+    while (!argument.atEnd()) {
+        if (buffered == qsizetype(buffer.size())) {
+            flush();
+        }
+        argument >> buffer[buffered++];
+    }
+    argument.endArray();
+    if (result.isEmpty()) {
+        result.reserve(buffered);
+    }
+    flush();
+    return result;
+}
+
+/**
+ * @internal
+ *
+ * Shortcut infos as the v3 methods of kglobalaccel send them, with the D-Bus signature
+ * (a(ss)a(ss)a(uussa(ai)a(ai))). The unique and friendly names of components and contexts are
+ * sent once in two tables that the shortcuts refer to by index, instead of in each shortcut as in
+ * a(ssssssaiai). The infos returned by infos() share the strings of the tables.
+ *
+ * Unlike a(ssssssaiai), which only has room for the first key of each sequence, keys are sent
+ * whole as (ai) like everywhere else. They are kept packed until infos() converts them.
+ *
+ * None of this is exported. The fake daemon of the autotests compiles kglobalshortcutinfotable.cpp
+ * itself to send tables.
+ */
+class KGlobalShortcutInfoTable
+{
+public:
+    /// Unique and friendly name of a component or context
+    using Names = std::pair<QString, QString>;
+
+    /// A shortcut, its component and context are indexes into the tables
+    struct Entry {
+        uint component = 0;
+        uint context = 0;
+        QString uniqueName;
+        QString friendlyName;
+        QList<PackedKeySequence> keys;
+        QList<PackedKeySequence> defaultKeys;
+    };
+
+    KGlobalShortcutInfoTable() = default;
+    /// Collects the names of the components and contexts of @p infos into the tables
+    explicit KGlobalShortcutInfoTable(const QList<KGlobalShortcutInfo> &infos);
+
+    QList<KGlobalShortcutInfo> infos() const;
+
+    /// Registers the table and its parts with QtDBus
+    static void registerMetaTypes();
+
+    QList<Names> components;
+    QList<Names> contexts;
+    QList<Entry> entries;
+};
+
+Q_DECLARE_METATYPE(PackedKeySequence)
+Q_DECLARE_METATYPE(KGlobalShortcutInfoTable)
+Q_DECLARE_METATYPE(KGlobalShortcutInfoTable::Entry)
+
+QDBusArgument &operator<<(QDBusArgument &argument, const PackedKeySequence &sequence);
+const QDBusArgument &operator>>(const QDBusArgument &argument, PackedKeySequence &sequence);
+QDBusArgument &operator<<(QDBusArgument &argument, const KGlobalShortcutInfoTable::Entry &entry);
+const QDBusArgument &operator>>(const QDBusArgument &argument, KGlobalShortcutInfoTable::Entry &entry);
+QDBusArgument &operator<<(QDBusArgument &argument, const KGlobalShortcutInfoTable &table);
+const QDBusArgument &operator>>(const QDBusArgument &argument, KGlobalShortcutInfoTable &table);
+
 #endif /* #ifndef KGLOBALSHORTCUTINFO_P_H */
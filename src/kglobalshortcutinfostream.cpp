@@ -0,0 +1,304 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kglobalshortcutinfostream.h"
+#include "kglobalaccel_debug.h"
+#include "kglobalaccel_p.h"
+
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
+#include <algorithm>
+
+class KGlobalShortcutInfoStreamPrivate
+{
+public:
+    explicit KGlobalShortcutInfoStreamPrivate(KGlobalShortcutInfoStream *qq)
+        : q(qq)
+    {
+    }
+
+    /// Calls @p handler with the reply to @p call unless the stream was cancelled or restarted
+    template<typename Handler>
+    void whenFinished(const QDBusPendingCall &call, Handler handler);
+    QDBusPendingCall callComponent(const QString &path, IpcCounters::Method method, const QVariantList &arguments = {});
+
+    void fetchPage();
+    /// Emit the page @p infos returned by kglobalaccel and fetch the next one if it was full
+    void pageReceived(const QList<KGlobalShortcutInfo> &infos);
+    /// kglobalaccel without shortcutInfos, go through the components one by one
+    void startFallback();
+    void fetchNextComponent();
+    void fetchNextContext();
+    /// Emit @p infos in pages, returns false if the stream was stopped in between
+    bool emitPages(const QList<KGlobalShortcutInfo> &infos);
+    void finish(const QString &error = QString());
+
+    KGlobalShortcutInfoStream *const q;
+
+    QString component;
+    QString context;
+    int pageSize = 100;
+
+    bool running = false;
+    //! Incremented by start() and cancel(), replies for older generations are dropped
+    quint64 generation = 0;
+    uint offset = 0;
+    QString error;
+
+    QStringList componentPaths;
+    //! Contexts left to list of the component at componentPaths.first()
+    QStringList contexts;
+};
+
+template<typename Handler>
+void KGlobalShortcutInfoStreamPrivate::whenFinished(const QDBusPendingCall &call, Handler handler)
+{
+    auto watcher = new QDBusPendingCallWatcher(call, q);
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished, q, [this, handler, generation = generation](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        if (running && generation == this->generation) {
+            handler(*watcher);
+        }
+    });
+}
+
+QDBusPendingCall KGlobalShortcutInfoStreamPrivate::callComponent(const QString &path, IpcCounters::Method method, const QVariantList &arguments)
+{
+    KGlobalAccelPrivate *const accel = KGlobalAccel::self()->d;
+    auto message =
+        QDBusMessage::createMethodCall(accel->iface()->service(), path, QStringLiteral("org.kde.kglobalaccel.Component"), IpcCounters::MethodNames[method]);
+    message.setArguments(arguments);
+    // The component methods we use take no argument or a context name
+    if (arguments.isEmpty()) {
+        accel->ipcCounters.countCall(method);
+    } else {
+        accel->ipcCounters.countCall(method, arguments.constFirst().toString());
+    }
+    return accel->bus().asyncCall(message);
+}
+
+void KGlobalShortcutInfoStreamPrivate::fetchPage()
+{
+    KGlobalAccelPrivate *const accel = KGlobalAccel::self()->d;
+    if (!accel->infoTablesUnsupported) {
+        accel->ipcCounters.countCall(IpcCounters::ShortcutInfoTable, component, context, offset, uint(pageSize));
+        const auto call = accel->iface()->shortcutInfoTable(component, context, offset, uint(pageSize));
+        whenFinished(call, [this, accel](const QDBusPendingCall &call) {
+            const QDBusPendingReply<KGlobalShortcutInfoTable> reply = call;
+            if (reply.isError()) {
+                if (reply.error().type() == QDBusError::UnknownMethod) {
+                    qCDebug(KGLOBALACCEL_LOG) << "kglobalaccel doesn't support shortcutInfoTable, using shortcutInfos";
+                    accel->infoTablesUnsupported = true;
+                    fetchPage();
+                } else {
+                    finish(reply.error().message());
+                }
+                return;
+            }
+            pageReceived(reply.value().infos());
+        });
+        return;
+    }
+
+    accel->ipcCounters.countCall(IpcCounters::ShortcutInfos, component, context, offset, uint(pageSize));
+    const auto call = accel->iface()->shortcutInfos(component, context, offset, uint(pageSize));
+    whenFinished(call, [this](const QDBusPendingCall &call) {
+        const QDBusPendingReply<QList<KGlobalShortcutInfo>> reply = call;
+        if (reply.isError()) {
+            if (reply.error().type() == QDBusError::UnknownMethod) {
+                qCDebug(KGLOBALACCEL_LOG) << "kglobalaccel doesn't support shortcutInfos, listing shortcuts by component";
+                startFallback();
+            } else {
+                finish(reply.error().message());
+            }
+            return;
+        }
+        pageReceived(reply.value());
+    });
+}
+
+void KGlobalShortcutInfoStreamPrivate::pageReceived(const QList<KGlobalShortcutInfo> &infos)
+{
+    offset += infos.size();
+    if (!emitPages(infos)) {
+        return;
+    }
+    if (infos.size() < pageSize) {
+        finish();
+    } else {
+        fetchPage();
+    }
+}
+
+void KGlobalShortcutInfoStreamPrivate::startFallback()
+{
+    KGlobalAccelPrivate *const accel = KGlobalAccel::self()->d;
+    if (!component.isEmpty()) {
+        accel->ipcCounters.countCall(IpcCounters::GetComponent, component);
+        whenFinished(accel->iface()->getComponent(component), [this](const QDBusPendingCall &call) {
+            const QDBusPendingReply<QDBusObjectPath> reply = call;
+            if (reply.isError()) {
+                // An unknown component has no shortcuts
+                finish(reply.error().name() == QLatin1String("org.kde.kglobalaccel.NoSuchComponent") ? QString() : reply.error().message());
+                return;
+            }
+            componentPaths = {reply.value().path()};
+            fetchNextComponent();
+        });
+        return;
+    }
+
+    accel->ipcCounters.countCall(IpcCounters::AllComponents);
+    whenFinished(accel->iface()->allComponents(), [this](const QDBusPendingCall &call) {
+        const QDBusPendingReply<QList<QDBusObjectPath>> reply = call;
+        if (reply.isError()) {
+            finish(reply.error().message());
+            return;
+        }
+        const QList<QDBusObjectPath> paths = reply.value();
+        for (const QDBusObjectPath &path : paths) {
+            componentPaths.append(path.path());
+        }
+        fetchNextComponent();
+    });
+}
+
+void KGlobalShortcutInfoStreamPrivate::fetchNextComponent()
+{
+    if (componentPaths.isEmpty()) {
+        finish();
+        return;
+    }
+
+    if (!context.isEmpty()) {
+        contexts = {context};
+        fetchNextContext();
+        return;
+    }
+    whenFinished(callComponent(componentPaths.constFirst(), IpcCounters::GetShortcutContexts), [this](const QDBusPendingCall &call) {
+        const QDBusPendingReply<QStringList> reply = call;
+        if (reply.isError()) {
+            finish(reply.error().message());
+            return;
+        }
+        contexts = reply.value();
+        fetchNextContext();
+    });
+}
+
+void KGlobalShortcutInfoStreamPrivate::fetchNextContext()
+{
+    if (contexts.isEmpty()) {
+        componentPaths.removeFirst();
+        fetchNextComponent();
+        return;
+    }
+
+    const QString nextContext = contexts.takeFirst();
+    whenFinished(callComponent(componentPaths.constFirst(), IpcCounters::AllShortcutInfos, {nextContext}), [this](const QDBusPendingCall &call) {
+        const QDBusPendingReply<QList<KGlobalShortcutInfo>> reply = call;
+        if (reply.isError()) {
+            finish(reply.error().message());
+            return;
+        }
+        if (emitPages(reply.value())) {
+            fetchNextContext();
+        }
+    });
+}
+
+bool KGlobalShortcutInfoStreamPrivate::emitPages(const QList<KGlobalShortcutInfo> &infos)
+{
+    const quint64 currentGeneration = generation;
+    for (qsizetype start = 0; start < infos.size(); start += pageSize) {
+        Q_EMIT q->pageReady(infos.mid(start, pageSize));
+        if (!running || generation != currentGeneration) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void KGlobalShortcutInfoStreamPrivate::finish(const QString &errorString)
+{
+    running = false;
+    error = errorString;
+    componentPaths.clear();
+    contexts.clear();
+    if (!error.isEmpty()) {
+        qCWarning(KGLOBALACCEL_LOG) << "Failed to list global shortcuts" << error;
+    }
+    Q_EMIT q->finished();
+}
+
+KGlobalShortcutInfoStream::KGlobalShortcutInfoStream(QObject *parent)
+    : QObject(parent)
+    , d(new KGlobalShortcutInfoStreamPrivate(this))
+{
+}
+
+KGlobalShortcutInfoStream::~KGlobalShortcutInfoStream() = default;
+
+void KGlobalShortcutInfoStream::setComponent(const QString &componentUnique)
+{
+    d->component = componentUnique;
+}
+
+QString KGlobalShortcutInfoStream::component() const
+{
+    return d->component;
+}
+
+void KGlobalShortcutInfoStream::setContext(const QString &context)
+{
+    d->context = context;
+}
+
+QString KGlobalShortcutInfoStream::context() const
+{
+    return d->context;
+}
+
+void KGlobalShortcutInfoStream::setPageSize(int pageSize)
+{
+    d->pageSize = std::max(pageSize, 1);
+}
+
+int KGlobalShortcutInfoStream::pageSize() const
+{
+    return d->pageSize;
+}
+
+void KGlobalShortcutInfoStream::start()
+{
+    cancel();
+    d->running = true;
+    d->offset = 0;
+    d->error.clear();
+    d->fetchPage();
+}
+
+void KGlobalShortcutInfoStream::cancel()
+{
+    ++d->generation;
+    d->running = false;
+    d->componentPaths.clear();
+    d->contexts.clear();
+}
+
+bool KGlobalShortcutInfoStream::isRunning() const
+{
+    return d->running;
+}
+
+QString KGlobalShortcutInfoStream::errorString() const
+{
+    return d->error;
+}
+
+#include "moc_kglobalshortcutinfostream.cpp"
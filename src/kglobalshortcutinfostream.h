@@ -0,0 +1,114 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KGLOBALSHORTCUTINFOSTREAM_H
+#define KGLOBALSHORTCUTINFOSTREAM_H
+
+#include "kglobalshortcutinfo.h"
+#include <kglobalaccel_export.h>
+
+#include <QList>
+#include <QObject>
+
+#include <memory>
+
+class KGlobalShortcutInfoStreamPrivate;
+
+/*!
+ * \class KGlobalShortcutInfoStream
+ * \inmodule KGlobalAccel
+ * \brief Lists the shortcuts known to the global shortcuts daemon in pages.
+ *
+ * Instead of fetching all shortcuts of all components at once, the stream asks the daemon for
+ * pageSize() shortcuts at a time and emits each page with pageReady() as soon as it arrives.
+ * Nothing blocks, and only one page is held at a time.
+ *
+ * \code
+ * auto stream = new KGlobalShortcutInfoStream(this);
+ * stream->setComponent(QStringLiteral("kwin"));
+ * connect(stream, &KGlobalShortcutInfoStream::pageReady, this, &Indexer::addShortcuts);
+ * connect(stream, &KGlobalShortcutInfoStream::finished, stream, &QObject::deleteLater);
+ * stream->start();
+ * \endcode
+ *
+ * Daemons that cannot page shortcuts are asked for one component at a time, the shortcuts of
+ * a component are then still split into pages.
+ *
+ * Shortcuts that are registered or removed while the stream is running may be skipped or
+ * emitted twice.
+ *
+ * \since 6.30
+ */
+class KGLOBALACCEL_EXPORT KGlobalShortcutInfoStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+     * Constructs a stream over all shortcuts of all components with the given \a parent.
+     */
+    explicit KGlobalShortcutInfoStream(QObject *parent = nullptr);
+    ~KGlobalShortcutInfoStream() override;
+
+    /*!
+     * Only list the shortcuts of the component \a componentUnique, or of all components if
+     * it is empty, which is the default.
+     */
+    void setComponent(const QString &componentUnique);
+    QString component() const;
+
+    /*!
+     * Only list the shortcuts of the global shortcut context \a context, or of all contexts
+     * if it is empty, which is the default.
+     */
+    void setContext(const QString &context);
+    QString context() const;
+
+    /*!
+     * Emit at most \a pageSize shortcuts with each pageReady(). The default is 100.
+     */
+    void setPageSize(int pageSize);
+    int pageSize() const;
+
+    /*!
+     * Starts listing the shortcuts, or starts over if the stream is running already.
+     */
+    void start();
+
+    /*!
+     * Stops the stream. No more signals are emitted until it is started again.
+     */
+    void cancel();
+
+    /*!
+     * Returns \c true between start() and finished().
+     */
+    bool isRunning() const;
+
+    /*!
+     * Returns a description of the error that ended the stream, or an empty string if it
+     * listed all shortcuts.
+     */
+    QString errorString() const;
+
+Q_SIGNALS:
+    /*!
+     * Emitted for each page of at most pageSize() \a infos.
+     */
+    void pageReady(const QList<KGlobalShortcutInfo> &infos);
+
+    /*!
+     * Emitted when all shortcuts have been listed, or when listing failed.
+     *
+     * \sa errorString()
+     */
+    void finished();
+
+private:
+    std::unique_ptr<KGlobalShortcutInfoStreamPrivate> const d;
+};
+
+#endif
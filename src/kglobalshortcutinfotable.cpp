@@ -0,0 +1,140 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+// The marshalling of KGlobalShortcutInfoTable, which the fake daemon of the autotests builds too.
+// Converting a table back to KGlobalShortcutInfo is done in kglobalshortcutinfo_dbus.cpp.
+
+#include "kglobalshortcutinfo_p.h"
+
+#include <QDBusMetaType>
+#include <QHash>
+
+#include <array>
+#include <functional>
+
+namespace
+{
+uint tableIndex(QHash<KGlobalShortcutInfoTable::Names, uint> &indexes, QList<KGlobalShortcutInfoTable::Names> &table, const QString &unique, const QString &friendly)
+{
+    KGlobalShortcutInfoTable::Names names(unique, friendly);
+    const auto it = indexes.constFind(names);
+    if (it != indexes.cend()) {
+        return *it;
+    }
+    const uint index = table.size();
+    indexes.insert(names, index);
+    table.append(std::move(names));
+    return index;
+}
+
+QList<PackedKeySequence> toPacked(const QList<QKeySequence> &sequences)
+{
+    QList<PackedKeySequence> packed;
+    packed.reserve(sequences.size());
+    for (const QKeySequence &sequence : sequences) {
+        packed.append(PackedKeySequence(sequence));
+    }
+    return packed;
+}
+
+QList<PackedKeySequence> readKeys(const QDBusArgument &argument)
+{
+    return readKeyArray<PackedKeySequence>(argument, std::identity());
+}
+}
+
+KGlobalShortcutInfoTable::KGlobalShortcutInfoTable(const QList<KGlobalShortcutInfo> &infos)
+{
+    QHash<Names, uint> componentIndexes;
+    QHash<Names, uint> contextIndexes;
+    entries.reserve(infos.size());
+    for (const KGlobalShortcutInfo &info : infos) {
+        Entry entry;
+        entry.component = tableIndex(componentIndexes, components, info.componentUniqueName(), info.componentFriendlyName());
+        entry.context = tableIndex(contextIndexes, contexts, info.contextUniqueName(), info.contextFriendlyName());
+        entry.uniqueName = info.uniqueName();
+        entry.friendlyName = info.friendlyName();
+        entry.keys = toPacked(info.keys());
+        entry.defaultKeys = toPacked(info.defaultKeys());
+        entries.append(std::move(entry));
+    }
+}
+
+void KGlobalShortcutInfoTable::registerMetaTypes()
+{
+    qDBusRegisterMetaType<PackedKeySequence>();
+    qDBusRegisterMetaType<QList<PackedKeySequence>>();
+    qDBusRegisterMetaType<Names>();
+    qDBusRegisterMetaType<QList<Names>>();
+    qDBusRegisterMetaType<Entry>();
+    qDBusRegisterMetaType<QList<Entry>>();
+    qDBusRegisterMetaType<KGlobalShortcutInfoTable>();
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const PackedKeySequence &sequence)
+{
+    argument.beginStructure();
+    argument.beginArray(qMetaTypeId<int>());
+    for (int i = 0; i < PackedKeySequence::MaxKeyCount; ++i) {
+        argument << sequence[i];
+    }
+    argument.endArray();
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, PackedKeySequence &sequence)
+{
+    std::array<int, PackedKeySequence::MaxKeyCount> keys{};
+    argument.beginStructure();
+    argument.beginArray();
+    // Keys beyond what a QKeySequence holds are skipped
+    for (int i = 0; !argument.atEnd(); ++i) {
+        int key;
+        argument >> key;
+        if (i < PackedKeySequence::MaxKeyCount) {
+            keys[i] = key;
+        }
+    }
+    argument.endArray();
+    argument.endStructure();
+    sequence = PackedKeySequence(keys[0], keys[1], keys[2], keys[3]);
+    return argument;
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const KGlobalShortcutInfoTable::Entry &entry)
+{
+    argument.beginStructure();
+    argument << entry.component << entry.context << entry.uniqueName << entry.friendlyName << entry.keys << entry.defaultKeys;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, KGlobalShortcutInfoTable::Entry &entry)
+{
+    argument.beginStructure();
+    argument >> entry.component >> entry.context >> entry.uniqueName >> entry.friendlyName;
+    entry.keys = readKeys(argument);
+    entry.defaultKeys = readKeys(argument);
+    argument.endStructure();
+    return argument;
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const KGlobalShortcutInfoTable &table)
+{
+    argument.beginStructure();
+    argument << table.components << table.contexts << table.entries;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, KGlobalShortcutInfoTable &table)
+{
+    argument.beginStructure();
+    argument >> table.components >> table.contexts >> table.entries;
+    argument.endStructure();
+    return argument;
+}
@@ -0,0 +1,209 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kglobalshortcutlatencystats.h"
+#include "kglobalaccel_latency_debug.h"
+#include "kglobalaccel_p.h"
+#include "shortcutlatencyrecorder_p.h"
+
+#include <QCoreApplication>
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+qint64 toMicroseconds(ShortcutLatencyRecorder::Clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+QLatin1String eventName(ShortcutLatencyRecorder::Event event)
+{
+    switch (event) {
+    case ShortcutLatencyRecorder::Pressed:
+        return QLatin1String("pressed");
+    case ShortcutLatencyRecorder::Repeated:
+        return QLatin1String("repeated");
+    case ShortcutLatencyRecorder::Released:
+        return QLatin1String("released");
+    }
+    return QLatin1String();
+}
+}
+
+bool ShortcutLatencyRecorder::isEnabled() const
+{
+    return m_users > 0 || KGLOBALACCEL_LATENCY_LOG().isDebugEnabled();
+}
+
+void ShortcutLatencyRecorder::addUser()
+{
+    if (++m_users == 1 && !m_ring) {
+        m_ring = std::make_unique<std::array<Sample, RingSize>>();
+    }
+}
+
+void ShortcutLatencyRecorder::removeUser()
+{
+    if (--m_users == 0) {
+        m_ring.reset();
+        m_next = 0;
+    }
+}
+
+void ShortcutLatencyRecorder::record(const QString &componentUnique,
+                                     const QString &actionUnique,
+                                     Event event,
+                                     qint64 daemonTimestamp,
+                                     Clock::time_point received,
+                                     Clock::time_point lookedUp,
+                                     Clock::time_point handled)
+{
+    if (!m_ring) {
+        // Only the logging category asked for measurements
+        m_ring = std::make_unique<std::array<Sample, RingSize>>();
+    }
+    Sample &sample = (*m_ring)[m_next++ % RingSize];
+    sample.action = ActionKey(componentUnique, actionUnique);
+    sample.event = event;
+    sample.daemonTimestamp = daemonTimestamp;
+    sample.received = received;
+    sample.lookedUp = lookedUp;
+    sample.handled = handled;
+
+    const auto latency = handled - received;
+    const auto bucket = std::lower_bound(BucketBounds.cbegin(), BucketBounds.cend(), latency);
+    ++m_histograms[sample.action][bucket - BucketBounds.cbegin()];
+
+    qCDebug(KGLOBALACCEL_LATENCY_LOG) << componentUnique << actionUnique << eventName(event) << "handled after" << toMicroseconds(latency)
+                                      << "us, lookup took" << toMicroseconds(lookedUp - received) << "us";
+}
+
+void ShortcutLatencyRecorder::reset()
+{
+    m_next = 0;
+    m_histograms.clear();
+}
+
+bool ShortcutLatencyRecorder::writeTrace(QIODevice *device) const
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    const quint64 count = m_ring ? std::min<quint64>(m_next, RingSize) : 0;
+    for (quint64 i = m_next - count; i < m_next; ++i) {
+        const Sample &sample = (*m_ring)[i % RingSize];
+        // One slice for the whole activation with the lookup as nested slice
+        events.append(QJsonObject{
+            {QStringLiteral("name"), QString(sample.action.first + QLatin1Char('/') + sample.action.second)},
+            {QStringLiteral("cat"), QStringLiteral("kglobalaccel")},
+            {QStringLiteral("ph"), QStringLiteral("X")},
+            {QStringLiteral("ts"), toMicroseconds(sample.received.time_since_epoch())},
+            {QStringLiteral("dur"), toMicroseconds(sample.handled - sample.received)},
+            {QStringLiteral("pid"), pid},
+            {QStringLiteral("tid"), 0},
+            {QStringLiteral("args"),
+             QJsonObject{
+                 {QStringLiteral("event"), eventName(sample.event)},
+                 {QStringLiteral("daemonTimestamp"), sample.daemonTimestamp},
+             }},
+        });
+        events.append(QJsonObject{
+            {QStringLiteral("name"), QStringLiteral("lookup")},
+            {QStringLiteral("cat"), QStringLiteral("kglobalaccel")},
+            {QStringLiteral("ph"), QStringLiteral("X")},
+            {QStringLiteral("ts"), toMicroseconds(sample.received.time_since_epoch())},
+            {QStringLiteral("dur"), toMicroseconds(sample.lookedUp - sample.received)},
+            {QStringLiteral("pid"), pid},
+            {QStringLiteral("tid"), 0},
+        });
+    }
+
+    const QJsonObject trace{
+        {QStringLiteral("traceEvents"), events},
+        {QStringLiteral("displayTimeUnit"), QStringLiteral("ms")},
+    };
+    const QByteArray json = QJsonDocument(trace).toJson(QJsonDocument::Compact);
+    return device->write(json) == json.size();
+}
+
+class KGlobalShortcutLatencyStatsPrivate
+{
+public:
+    ShortcutLatencyRecorder *recorder() const
+    {
+        return &KGlobalAccel::self()->d->latency;
+    }
+};
+
+KGlobalShortcutLatencyStats::KGlobalShortcutLatencyStats(QObject *parent)
+    : QObject(parent)
+    , d(new KGlobalShortcutLatencyStatsPrivate)
+{
+    d->recorder()->addUser();
+}
+
+KGlobalShortcutLatencyStats::~KGlobalShortcutLatencyStats()
+{
+    d->recorder()->removeUser();
+}
+
+QList<std::chrono::microseconds> KGlobalShortcutLatencyStats::bucketBounds()
+{
+    return QList<std::chrono::microseconds>(ShortcutLatencyRecorder::BucketBounds.cbegin(), ShortcutLatencyRecorder::BucketBounds.cend());
+}
+
+QStringList KGlobalShortcutLatencyStats::components() const
+{
+    QStringList components;
+    const auto &histograms = d->recorder()->histograms();
+    for (auto it = histograms.cbegin(); it != histograms.cend(); ++it) {
+        if (!components.contains(it.key().first)) {
+            components.append(it.key().first);
+        }
+    }
+    return components;
+}
+
+QStringList KGlobalShortcutLatencyStats::actions(const QString &componentUnique) const
+{
+    QStringList actions;
+    const auto &histograms = d->recorder()->histograms();
+    for (auto it = histograms.cbegin(); it != histograms.cend(); ++it) {
+        if (it.key().first == componentUnique) {
+            actions.append(it.key().second);
+        }
+    }
+    return actions;
+}
+
+QList<int> KGlobalShortcutLatencyStats::histogram(const QString &componentUnique, const QString &actionUnique) const
+{
+    const ShortcutLatencyRecorder::Histogram histogram = d->recorder()->histograms().value({componentUnique, actionUnique});
+    return QList<int>(histogram.cbegin(), histogram.cend());
+}
+
+int KGlobalShortcutLatencyStats::activationCount(const QString &componentUnique, const QString &actionUnique) const
+{
+    const ShortcutLatencyRecorder::Histogram histogram = d->recorder()->histograms().value({componentUnique, actionUnique});
+    return std::accumulate(histogram.cbegin(), histogram.cend(), 0);
+}
+
+void KGlobalShortcutLatencyStats::reset()
+{
+    d->recorder()->reset();
+}
+
+bool KGlobalShortcutLatencyStats::writeTrace(QIODevice *device) const
+{
+    return d->recorder()->writeTrace(device);
+}
+
+#include "moc_kglobalshortcutlatencystats.cpp"
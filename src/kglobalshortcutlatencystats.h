@@ -0,0 +1,106 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KGLOBALSHORTCUTLATENCYSTATS_H
+#define KGLOBALSHORTCUTLATENCYSTATS_H
+
+#include <kglobalaccel_export.h>
+
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+#include <chrono>
+#include <memory>
+
+class QIODevice;
+class KGlobalShortcutLatencyStatsPrivate;
+
+/*!
+ * \class KGlobalShortcutLatencyStats
+ * \inmodule KGlobalAccel
+ * \brief Measures how quickly the application reacts to global shortcuts.
+ *
+ * While a stats object exists, KGlobalAccel measures the time from receiving a pressed,
+ * repeated or released signal of the global shortcuts daemon until the action was triggered,
+ * or until globalShortcutActiveChanged() was emitted for a release. Slow slots connected to
+ * QAction::triggered() show up as high latency of their action.
+ *
+ * \code
+ * auto stats = new KGlobalShortcutLatencyStats(this);
+ * // ... later
+ * const QList<int> counts = stats->histogram(QStringLiteral("myapp"), QStringLiteral("toggle"));
+ * \endcode
+ *
+ * All stats objects share the same measurements, which are also logged to the
+ * \c kf.globalaccel.latency logging category if its debug output is enabled. The time the
+ * daemon took to send a signal is not included, the timestamp it sends along is in the time
+ * base of the windowing system, it is only passed on in writeTrace().
+ *
+ * Global shortcuts are handled on the main thread, so the stats object must be used there too.
+ *
+ * \since 6.30
+ */
+class KGLOBALACCEL_EXPORT KGlobalShortcutLatencyStats : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+     * Constructs a stats object with the given \a parent and starts measuring.
+     */
+    explicit KGlobalShortcutLatencyStats(QObject *parent = nullptr);
+
+    /*!
+     * Stops measuring unless other stats objects exist. The activations for writeTrace() are
+     * discarded with the last stats object.
+     */
+    ~KGlobalShortcutLatencyStats() override;
+
+    /*!
+     * Returns the upper bounds of the buckets of histogram(). There is one more bucket than
+     * bounds, for everything slower than the last bound.
+     */
+    static QList<std::chrono::microseconds> bucketBounds();
+
+    /*!
+     * Returns the components with actions that were activated.
+     */
+    QStringList components() const;
+
+    /*!
+     * Returns the actions of the component \a componentUnique that were activated.
+     */
+    QStringList actions(const QString &componentUnique) const;
+
+    /*!
+     * Returns how many activations of the action \a actionUnique of the component
+     * \a componentUnique fell into each bucket, see bucketBounds().
+     */
+    QList<int> histogram(const QString &componentUnique, const QString &actionUnique) const;
+
+    /*!
+     * Returns how often the action \a actionUnique of the component \a componentUnique was
+     * activated.
+     */
+    int activationCount(const QString &componentUnique, const QString &actionUnique) const;
+
+    /*!
+     * Discards all measurements.
+     */
+    void reset();
+
+    /*!
+     * Writes the most recent activations to \a device in the Chrome trace event format, which
+     * can be opened with Perfetto or chrome://tracing. Returns \c false if writing failed.
+     */
+    bool writeTrace(QIODevice *device) const;
+
+private:
+    std::unique_ptr<KGlobalShortcutLatencyStatsPrivate> const d;
+};
+
+#endif
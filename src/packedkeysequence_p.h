@@ -0,0 +1,138 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef PACKEDKEYSEQUENCE_P_H
+#define PACKEDKEYSEQUENCE_P_H
+
+#include <QKeySequence>
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+
+/**
+ * @internal
+ *
+ * A key sequence as the combined ints of its up to four keys, like kglobalaccel sends it over
+ * D-Bus. Unlike QKeySequence it is a plain value that never allocates, so use it for comparing
+ * and transforming sequences and only convert to QKeySequence where the public API needs one.
+ *
+ * As in QKeySequence the sequence ends at the first key that is 0.
+ */
+class PackedKeySequence
+{
+public:
+    static constexpr int MaxKeyCount = 4;
+
+    constexpr PackedKeySequence() = default;
+    constexpr explicit PackedKeySequence(int k1, int k2 = 0, int k3 = 0, int k4 = 0)
+        : m_keys{k1, k2, k3, k4}
+    {
+        // Keys after the end don't count, drop them so that == works
+        for (int i = count(); i < MaxKeyCount; ++i) {
+            m_keys[i] = 0;
+        }
+    }
+    explicit PackedKeySequence(const QKeySequence &sequence)
+    {
+        const int length = std::min(sequence.count(), MaxKeyCount);
+        for (int i = 0; i < length; ++i) {
+            m_keys[i] = sequence[i].toCombined();
+        }
+    }
+
+    QKeySequence toKeySequence() const
+    {
+        return QKeySequence(m_keys[0], m_keys[1], m_keys[2], m_keys[3]);
+    }
+
+    constexpr int count() const
+    {
+        int length = 0;
+        while (length < MaxKeyCount && m_keys[length] != 0) {
+            ++length;
+        }
+        return length;
+    }
+
+    constexpr bool isEmpty() const
+    {
+        return m_keys[0] == 0;
+    }
+
+    constexpr int operator[](int index) const
+    {
+        return m_keys[index];
+    }
+
+    /// The keys in reverse order
+    constexpr PackedKeySequence reversed() const
+    {
+        PackedKeySequence result;
+        const int length = count();
+        for (int i = 0; i < length; ++i) {
+            result.m_keys[length - i - 1] = m_keys[i];
+        }
+        return result;
+    }
+
+    /// Without the first @p keys keys, empty if the sequence is shorter than that
+    constexpr PackedKeySequence cropped(int keys) const
+    {
+        if (keys < 1) {
+            return *this;
+        }
+        PackedKeySequence result;
+        for (int i = keys; i < count(); ++i) {
+            result.m_keys[i - keys] = m_keys[i];
+        }
+        return result;
+    }
+
+    /// Qt triggers both shortcuts that include Shift+Backtab and Shift+Tab when the user presses
+    /// Shift+Tab, so kglobalaccel makes no difference between them
+    constexpr PackedKeySequence mangled() const
+    {
+        PackedKeySequence result = *this;
+        for (int i = 0; i < count(); ++i) {
+            const int keySym = m_keys[i] & ~Qt::KeyboardModifierMask;
+            const int keyMod = m_keys[i] & Qt::KeyboardModifierMask;
+            if ((keyMod & Qt::SHIFT) && (keySym == Qt::Key_Backtab || keySym == Qt::Key_Tab)) {
+                result.m_keys[i] = keyMod | Qt::Key_Tab;
+            }
+        }
+        return result;
+    }
+
+    /// Whether this sequence occurs in @p other as a contiguous part that is shorter than @p other
+    constexpr bool isProperPartOf(const PackedKeySequence &other) const
+    {
+        const int length = count();
+        const int otherLength = other.count();
+        if (length == 0 || length >= otherLength) {
+            return false;
+        }
+        for (int start = 0; start + length <= otherLength; ++start) {
+            bool match = true;
+            for (int i = 0; i < length && match; ++i) {
+                match = m_keys[i] == other.m_keys[start + i];
+            }
+            if (match) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    friend constexpr bool operator==(const PackedKeySequence &lhs, const PackedKeySequence &rhs) = default;
+
+private:
+    std::array<int, MaxKeyCount> m_keys{};
+};
+
+static_assert(std::is_trivially_copyable_v<PackedKeySequence>);
+
+#endif
@@ -1,60 +1,43 @@
 #include <QKeySequence>
 
 #include "kglobalshortcutinfo_p.h"
+#include "packedkeysequence_p.h"
 #include "sequencehelpers_p.h"
 
+static_assert(PackedKeySequence::MaxKeyCount == maxSequenceLength);
+
+static constexpr int combined(QKeyCombination combination)
+{
+    return combination.toCombined();
+}
+
+// (Alt+B, Alt+F, Alt+G)
+static constexpr PackedKeySequence s_bfg(combined(Qt::ALT | Qt::Key_B), combined(Qt::ALT | Qt::Key_F), combined(Qt::ALT | Qt::Key_G));
+static_assert(s_bfg.count() == 3);
+static_assert(s_bfg.reversed() == PackedKeySequence(combined(Qt::ALT | Qt::Key_G), combined(Qt::ALT | Qt::Key_F), combined(Qt::ALT | Qt::Key_B)));
+static_assert(s_bfg.cropped(1) == PackedKeySequence(combined(Qt::ALT | Qt::Key_F), combined(Qt::ALT | Qt::Key_G)));
+static_assert(s_bfg.cropped(3).isEmpty() && s_bfg.cropped(4).isEmpty());
+static_assert(PackedKeySequence(combined(Qt::ALT | Qt::Key_F)).isProperPartOf(s_bfg));
+static_assert(PackedKeySequence(combined(Qt::ALT | Qt::Key_F), combined(Qt::ALT | Qt::Key_G)).isProperPartOf(s_bfg));
+static_assert(!s_bfg.isProperPartOf(s_bfg));
+static_assert(!PackedKeySequence(combined(Qt::ALT | Qt::Key_B), combined(Qt::ALT | Qt::Key_G)).isProperPartOf(s_bfg));
+static_assert(PackedKeySequence(combined(Qt::SHIFT | Qt::Key_Backtab)).mangled() == PackedKeySequence(combined(Qt::SHIFT | Qt::Key_Tab)));
+
 namespace Utils
 {
 QKeySequence reverseKey(const QKeySequence &key)
 {
-    int k[maxSequenceLength] = {0, 0, 0, 0};
-    int count = key.count();
-    for (int i = 0; i < count; i++) {
-        k[count - i - 1] = key[i].toCombined();
-    }
-
-    return QKeySequence(k[0], k[1], k[2], k[3]);
+    return PackedKeySequence(key).reversed().toKeySequence();
 }
 
 QKeySequence cropKey(const QKeySequence &key, int count)
 {
-    if (count < 1) {
-        return key;
-    }
-
-    // Key is shorter than count we want to cut off
-    if (key.count() < count) {
-        return QKeySequence();
-    }
-
-    int k[maxSequenceLength] = {0, 0, 0, 0};
-    // cut from beginning
-    for (int i = count; i < key.count(); i++) {
-        k[i - count] = key[i].toCombined();
-    }
-
-    return QKeySequence(k[0], k[1], k[2], k[3]);
+    return PackedKeySequence(key).cropped(count).toKeySequence();
 }
 
 bool contains(const QKeySequence &key, const QKeySequence &other)
 {
-    int minLength = std::min(key.count(), other.count());
-
-    // There's an empty key, assume it matches nothing
-    if (!minLength) {
-        return false;
-    }
-
-    bool ret = false;
-    for (int i = 0; i <= other.count() - minLength; i++) {
-        QKeySequence otherCropped = cropKey(other, i);
-        if (key.matches(otherCropped) == QKeySequence::PartialMatch || reverseKey(key).matches(reverseKey(otherCropped)) == QKeySequence::PartialMatch) {
-            ret = true;
-            break;
-        }
-    }
-
-    return ret;
+    return PackedKeySequence(key).isProperPartOf(PackedKeySequence(other));
 }
 
 bool matchSequences(const QKeySequence &key, const QList<QKeySequence> &keys)
@@ -69,11 +52,13 @@ bool matchSequences(const QKeySequence &key, const QList<QKeySequence> &keys)
     // 4) Shadowing at the end: (Alt+F, Alt+G)
     // 5) Being shadowed from the end: (<any key>, Alt+B, Alt+F, Alt+G)
 
+    const PackedKeySequence packedKey(key);
     for (const QKeySequence &otherKey : keys) {
-        if (otherKey.isEmpty()) {
+        const PackedKeySequence packedOther(otherKey);
+        if (packedOther.isEmpty()) {
             continue;
         }
-        if (key.matches(otherKey) == QKeySequence::ExactMatch || contains(key, otherKey) || contains(otherKey, key)) {
+        if (packedKey == packedOther || packedKey.isProperPartOf(packedOther) || packedOther.isProperPartOf(packedKey)) {
             return true;
         }
     }
@@ -82,22 +67,7 @@ bool matchSequences(const QKeySequence &key, const QList<QKeySequence> &keys)
 
 QKeySequence mangleKey(const QKeySequence &key)
 {
-    // Qt triggers both shortcuts that include Shift+Backtab and Shift+Tab
-    // when user presses Shift+Tab. Make no difference here.
-    int k[maxSequenceLength] = {0, 0, 0, 0};
-    for (int i = 0; i < key.count(); i++) {
-        // Qt triggers both shortcuts that include Shift+Backtab and Shift+Tab
-        // when user presses Shift+Tab. Make no difference here.
-        int keySym = key[i].toCombined() & ~Qt::KeyboardModifierMask;
-        int keyMod = key[i].toCombined() & Qt::KeyboardModifierMask;
-        if ((keyMod & Qt::SHIFT) && (keySym == Qt::Key_Backtab || keySym == Qt::Key_Tab)) {
-            k[i] = keyMod | Qt::Key_Tab;
-        } else {
-            k[i] = key[i].toCombined();
-        }
-    }
-
-    return QKeySequence(k[0], k[1], k[2], k[3]);
+    return PackedKeySequence(key).mangled().toKeySequence();
 }
 
 } // namespace Utils
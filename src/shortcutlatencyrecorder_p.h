@@ -0,0 +1,104 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef SHORTCUTLATENCYRECORDER_P_H
+#define SHORTCUTLATENCYRECORDER_P_H
+
+#include <QHash>
+#include <QString>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <utility>
+
+class QIODevice;
+
+/**
+ * @internal
+ *
+ * Records how long it takes from receiving a shortcut signal of kglobalaccel until the action
+ * was triggered, see KGlobalShortcutLatencyStats.
+ *
+ * Signals are dispatched on the main thread only, so recording needs no locking. The ring of
+ * recent activations is allocated with the first recorded activation, overwritten in place and
+ * freed once the last user is gone. Recording an activation otherwise only allocates for the
+ * first activation of each action.
+ */
+class ShortcutLatencyRecorder
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    /// Component and action unique name
+    using ActionKey = std::pair<QString, QString>;
+
+    enum Event {
+        Pressed,
+        Repeated,
+        Released,
+    };
+
+    /// Upper bounds of the histogram buckets, the last bucket has no upper bound
+    static constexpr std::array<std::chrono::microseconds, 11> BucketBounds{std::chrono::microseconds(50),
+                                                                            std::chrono::microseconds(100),
+                                                                            std::chrono::microseconds(250),
+                                                                            std::chrono::microseconds(500),
+                                                                            std::chrono::milliseconds(1),
+                                                                            std::chrono::microseconds(2500),
+                                                                            std::chrono::milliseconds(5),
+                                                                            std::chrono::milliseconds(10),
+                                                                            std::chrono::milliseconds(25),
+                                                                            std::chrono::milliseconds(50),
+                                                                            std::chrono::milliseconds(100)};
+    static constexpr int BucketCount = BucketBounds.size() + 1;
+    using Histogram = std::array<int, BucketCount>;
+
+    struct Sample {
+        ActionKey action;
+        Event event = Pressed;
+        /// The timestamp kglobalaccel sent along, in the time base of the windowing system
+        qint64 daemonTimestamp = 0;
+        Clock::time_point received;
+        Clock::time_point lookedUp;
+        Clock::time_point handled;
+    };
+    static constexpr int RingSize = 512;
+
+    /// Whether activations should be measured at all, cheap enough to ask on every signal
+    bool isEnabled() const;
+    /// While there are users activations are recorded, otherwise only if the latency logging
+    /// category is enabled. The recent activations are discarded with the last user.
+    void addUser();
+    void removeUser();
+
+    void record(const QString &componentUnique,
+                const QString &actionUnique,
+                Event event,
+                qint64 daemonTimestamp,
+                Clock::time_point received,
+                Clock::time_point lookedUp,
+                Clock::time_point handled);
+    void reset();
+
+    const QHash<ActionKey, Histogram> &histograms() const
+    {
+        return m_histograms;
+    }
+
+    /// Write the recent activations as Chrome trace event JSON, which Perfetto can open
+    bool writeTrace(QIODevice *device) const;
+
+private:
+    int m_users = 0;
+    //! Only allocated while activations are recorded, it is too large to keep around otherwise
+    std::unique_ptr<std::array<Sample, RingSize>> m_ring;
+    //! Number of samples recorded since the ring was allocated or reset, the next one goes to
+    //! m_next % RingSize
+    quint64 m_next = 0;
+    QHash<ActionKey, Histogram> m_histograms;
+};
+
+#endif
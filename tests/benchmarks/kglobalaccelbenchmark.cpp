@@ -0,0 +1,300 @@
+/*
+    This file is part of the KDE libraries
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "fakekglobalacceld.h"
+
+#include <KGlobalAccel>
+#include <QAction>
+#include <QApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QXmlStreamReader>
+
+#include <kglobalaccel_version.h>
+
+namespace
+{
+const QString s_component = QStringLiteral("kglobalaccelbenchmark");
+}
+
+/*
+ * Measures the client side of KGlobalAccel against FakeKGlobalAccelDaemon.
+ *
+ * Pass --json <file> to get the results in machine-readable form in addition to the usual output,
+ * all other arguments are handed to QTest.
+ */
+class KGlobalAccelBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void benchmarkRegister_data();
+    void benchmarkRegister();
+    void benchmarkPressToTrigger_data();
+    void benchmarkPressToTrigger();
+    void benchmarkReRegisterAll_data();
+    void benchmarkReRegisterAll();
+    void benchmarkGlobalShortcutsByKey_data();
+    void benchmarkGlobalShortcutsByKey();
+
+private:
+    QList<QAction *> createActions(int count);
+    void registerActions(const QList<QAction *> &actions);
+
+    FakeKGlobalAccelDaemon *m_daemon = nullptr;
+    QList<QAction *> m_actions;
+    int m_nextAction = 0;
+};
+
+QList<QAction *> KGlobalAccelBenchmark::createActions(int count)
+{
+    QList<QAction *> actions;
+    actions.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        // Unique names, so every registration is a new one for the daemon
+        const QString name = QStringLiteral("action%1").arg(m_nextAction++);
+        auto action = new QAction(name, this);
+        action->setObjectName(name);
+        action->setProperty("componentName", s_component);
+        actions.append(action);
+    }
+    m_actions += actions;
+    return actions;
+}
+
+void KGlobalAccelBenchmark::registerActions(const QList<QAction *> &actions)
+{
+    for (QAction *action : actions) {
+        // No keys, so that thousands of actions don't run out of distinct shortcuts
+        KGlobalAccel::self()->setShortcut(action, {}, KGlobalAccel::NoAutoloading);
+    }
+}
+
+void KGlobalAccelBenchmark::initTestCase()
+{
+    m_daemon = new FakeKGlobalAccelDaemon(this);
+    if (!m_daemon->start()) {
+        QSKIP("Could not start a private D-Bus session");
+    }
+}
+
+void KGlobalAccelBenchmark::cleanup()
+{
+    for (QAction *action : std::as_const(m_actions)) {
+        KGlobalAccel::self()->removeAllShortcuts(action);
+    }
+    qDeleteAll(m_actions);
+    m_actions.clear();
+}
+
+void KGlobalAccelBenchmark::benchmarkRegister_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("batched");
+
+    for (int count : {10, 100, 400}) {
+        QTest::addRow("%d actions", count) << count << false;
+        QTest::addRow("%d actions, batched", count) << count << true;
+    }
+}
+
+void KGlobalAccelBenchmark::benchmarkRegister()
+{
+    QFETCH(int, count);
+    QFETCH(bool, batched);
+
+    QBENCHMARK {
+        const QList<QAction *> actions = createActions(count);
+        if (batched) {
+            KGlobalAccel::self()->beginBatch();
+        }
+        registerActions(actions);
+        if (batched) {
+            KGlobalAccel::self()->commitBatch();
+        }
+    }
+}
+
+void KGlobalAccelBenchmark::benchmarkPressToTrigger_data()
+{
+    QTest::addColumn<int>("count");
+
+    for (int count : {1, 100, 1000}) {
+        QTest::addRow("%d actions", count) << count;
+    }
+}
+
+void KGlobalAccelBenchmark::benchmarkPressToTrigger()
+{
+    QFETCH(int, count);
+
+    const QList<QAction *> actions = createActions(count);
+    KGlobalAccel::self()->beginBatch();
+    registerActions(actions);
+    KGlobalAccel::self()->commitBatch();
+
+    QAction *action = actions.last();
+    int triggered = 0;
+    connect(action, &QAction::triggered, this, [&triggered] {
+        ++triggered;
+    });
+
+    QBENCHMARK {
+        const int expected = triggered + 1;
+        m_daemon->press(s_component, action->objectName());
+        while (triggered < expected) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+        m_daemon->release(s_component, action->objectName());
+    }
+}
+
+void KGlobalAccelBenchmark::benchmarkReRegisterAll_data()
+{
+    QTest::addColumn<int>("count");
+
+    for (int count : {10, 100, 400}) {
+        QTest::addRow("%d actions", count) << count;
+    }
+}
+
+void KGlobalAccelBenchmark::benchmarkReRegisterAll()
+{
+    QFETCH(int, count);
+
+    const QList<QAction *> actions = createActions(count);
+    KGlobalAccel::self()->beginBatch();
+    registerActions(actions);
+    KGlobalAccel::self()->commitBatch();
+    QCOMPARE(m_daemon->presentCount(s_component), count);
+
+    QSignalSpy restoredSpy(KGlobalAccel::self(), &KGlobalAccel::globalShortcutsRestored);
+    QBENCHMARK {
+        m_daemon->restart();
+        QVERIFY(restoredSpy.wait());
+    }
+    QCOMPARE(m_daemon->presentCount(s_component), count);
+}
+
+void KGlobalAccelBenchmark::benchmarkGlobalShortcutsByKey_data()
+{
+    QTest::addColumn<int>("count");
+
+    for (int count : {10, 100, 1000}) {
+        QTest::addRow("%d actions", count) << count;
+    }
+}
+
+void KGlobalAccelBenchmark::benchmarkGlobalShortcutsByKey()
+{
+    QFETCH(int, count);
+
+    const QList<QAction *> actions = createActions(count);
+    KGlobalAccel::self()->beginBatch();
+    registerActions(actions);
+    KGlobalAccel::self()->setShortcut(actions.first(), {QKeySequence(Qt::META | Qt::Key_F12)}, KGlobalAccel::NoAutoloading);
+    KGlobalAccel::self()->commitBatch();
+
+    QBENCHMARK {
+        const QList<KGlobalShortcutInfo> infos = KGlobalAccel::globalShortcutsByKey(QKeySequence(Qt::META | Qt::Key_F12));
+        QCOMPARE(infos.size(), 1);
+    }
+}
+
+// Turns the benchmark results of a QTest XML log into JSON
+static bool writeJsonResults(const QString &xmlFileName, const QString &jsonFileName)
+{
+    QFile xmlFile(xmlFileName);
+    if (!xmlFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QJsonArray results;
+    QString function;
+    QXmlStreamReader reader(&xmlFile);
+    while (!reader.atEnd()) {
+        if (reader.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+        const QXmlStreamAttributes attributes = reader.attributes();
+        if (reader.name() == QLatin1String("TestFunction")) {
+            function = attributes.value(QLatin1String("name")).toString();
+        } else if (reader.name() == QLatin1String("BenchmarkResult")) {
+            const double value = attributes.value(QLatin1String("value")).toDouble();
+            const int iterations = attributes.value(QLatin1String("iterations")).toInt();
+            results.append(QJsonObject{
+                {QStringLiteral("function"), function},
+                {QStringLiteral("tag"), attributes.value(QLatin1String("tag")).toString()},
+                {QStringLiteral("metric"), attributes.value(QLatin1String("metric")).toString()},
+                {QStringLiteral("value"), value},
+                {QStringLiteral("iterations"), iterations},
+                {QStringLiteral("valuePerIteration"), iterations > 0 ? value / iterations : value},
+            });
+        }
+    }
+    if (reader.hasError()) {
+        qWarning() << "Failed to parse benchmark results" << reader.errorString();
+        return false;
+    }
+
+    QFile jsonFile(jsonFileName);
+    if (!jsonFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to write" << jsonFileName << jsonFile.errorString();
+        return false;
+    }
+    const QJsonObject root{
+        {QStringLiteral("version"), QStringLiteral(KGLOBALACCEL_VERSION_STRING)},
+        {QStringLiteral("results"), results},
+    };
+    jsonFile.write(QJsonDocument(root).toJson());
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    // The random delay before restoring shortcuts after a restart would dominate benchmarkReRegisterAll
+    qputenv("KGLOBALACCEL_RESTORE_JITTER", "0");
+    QApplication app(argc, argv);
+
+    QStringList arguments = app.arguments();
+    QString jsonFileName;
+    const qsizetype jsonIndex = arguments.indexOf(QLatin1String("--json"));
+    if (jsonIndex > 0 && jsonIndex + 1 < arguments.size()) {
+        jsonFileName = arguments.at(jsonIndex + 1);
+        arguments.remove(jsonIndex, 2);
+    }
+
+    QTemporaryFile xmlFile;
+    if (!jsonFileName.isEmpty()) {
+        if (!xmlFile.open()) {
+            qWarning() << "Failed to create a temporary file for the results";
+            return 1;
+        }
+        xmlFile.close();
+        arguments << QStringLiteral("-o") << xmlFile.fileName() + QLatin1String(",xml") << QStringLiteral("-o") << QStringLiteral("-,txt");
+    }
+
+    KGlobalAccelBenchmark benchmark;
+    const int result = QTest::qExec(&benchmark, arguments);
+
+    if (!jsonFileName.isEmpty() && !writeJsonResults(xmlFile.fileName(), jsonFileName)) {
+        return result ? result : 1;
+    }
+    return result;
+}
+
+#include "kglobalaccelbenchmark.moc"